@@ -0,0 +1,197 @@
+// Camera: orthographic or perspective projection and frustum culling
+// 相机：正交或透视投影，以及视锥剔除（整个网格的包围球、高度场的逐行包围球）
+//
+// Coordinates are view space in pixels: x right, y away from the viewer
+// (depth), z up, origin at the centre of the screen. The perspective eye
+// sits at y = -focal, so the plane y = 0 keeps the orthographic scale and
+// the demos look the same size in either mode.
+//
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include "el.h"
+#include "fast_math.h"
+#include "transform.h"
+#include "simple_gfx.h"
+
+// Vertical field of view of the demo camera in degrees, 0 = orthographic
+// (cmake -DCAMERA_FOV_DEG=N)
+#ifndef CAMERA_FOV_DEG
+#define CAMERA_FOV_DEG 45
+#endif
+
+// Near plane in pixels in front of the eye
+#ifndef CAMERA_NEAR
+#define CAMERA_NEAR 16.0f
+#endif
+
+// Frustum plane: a point p is inside when nx*x + ny*y + nz*z <= e (n unit)
+typedef struct {
+    float nx, ny, nz, e;
+} CameraPlane;
+
+#define CAMERA_NEAR_PLANE 0       // index in Camera.planes (perspective only)
+#define CAMERA_MAX_PLANES 5
+
+typedef struct {
+    bool perspective;
+    float focal;          // eye distance to the plane y = 0, in pixels
+    geom_t focal_g;       // the same in geom_t
+    float near;
+    CameraPlane planes[CAMERA_MAX_PLANES];
+    int num_planes;
+} Camera;
+
+// Result of a bounding sphere test, ordered by how much work is left
+typedef enum {
+    CULL_INSIDE,          // wholly in view, no per-part tests needed
+    CULL_PARTIAL,         // crosses a side of the screen
+    CULL_NEAR,            // crosses the near plane: not drawn, parts behind
+                          // the eye cannot be projected
+    CULL_OUTSIDE,         // wholly out of view
+} CullResult;
+
+static inline void camera_add_plane(Camera *cam, float nx, float ny, float nz, float e) {
+    float len = sqrtf(nx * nx + ny * ny + nz * nz);
+    cam->planes[cam->num_planes++] = (CameraPlane){ nx / len, ny / len, nz / len, e / len };
+}
+
+// fov_deg = 0 gives the orthographic camera
+static inline void camera_init(Camera *cam, float fov_deg, float near) {
+    const float hw = SCR_WIDTH / 2, hh = SCR_HEIGHT / 2;
+    *cam = (Camera){ .perspective = fov_deg > 0.0f, .near = near };
+    if (!cam->perspective) {
+        camera_add_plane(cam, 1.0f, 0.0f, 0.0f, hw);
+        camera_add_plane(cam, -1.0f, 0.0f, 0.0f, hw);
+        camera_add_plane(cam, 0.0f, 0.0f, 1.0f, hh);
+        camera_add_plane(cam, 0.0f, 0.0f, -1.0f, hh);
+        return;
+    }
+    const float f = hh / tanf(fov_deg * (float)M_PI / 360.0f);
+    cam->focal = f;
+    cam->focal_g = GEOM_FROM_FLOAT(f);
+    // Near first (CAMERA_NEAR_PLANE), then x * f <= hw * (y + f) and the like
+    camera_add_plane(cam, 0.0f, -1.0f, 0.0f, f - near);
+    camera_add_plane(cam, f, -hw, 0.0f, hw * f);
+    camera_add_plane(cam, -f, -hw, 0.0f, hw * f);
+    camera_add_plane(cam, 0.0f, -hh, f, hh * f);
+    camera_add_plane(cam, 0.0f, -hh, -f, hh * f);
+}
+
+static inline CullResult camera_cull_sphere(const Camera *cam, float cx, float cy, float cz, float r) {
+    CullResult res = CULL_INSIDE;
+    for (int k = 0; k < cam->num_planes; k++) {
+        const CameraPlane *p = &cam->planes[k];
+        float d = p->nx * cx + p->ny * cy + p->nz * cz - p->e;
+        if (d > r) return CULL_OUTSIDE;
+        if (d > -r) {
+            CullResult part = cam->perspective && k == CAMERA_NEAR_PLANE ? CULL_NEAR : CULL_PARTIAL;
+            if (part > res) res = part;
+        }
+    }
+    return res;
+}
+
+// Perspective scale focal / (focal + depth) of a point in front of the near
+// plane, by the fast reciprocal of the backend
+static inline geom_t camera_depth_scale(const Camera *cam, geom_t depth) {
+#if GEOM_FIXED_POINT
+    return fast_div_q16(cam->focal_g, cam->focal_g + depth);
+#else
+    return cam->focal * fast_recipf(cam->focal + depth);
+#endif
+}
+
+// Project a view-space point (in pixels) to the screen
+static inline void camera_project(const Camera *cam, geom_t x, geom_t y, geom_t z, ScreenVertex *s) {
+    if (cam->perspective) {
+        const geom_t k = camera_depth_scale(cam, y);
+        x = GEOM_MUL(x, k);
+        z = GEOM_MUL(z, k);
+    }
+    s->x = SCR_WIDTH / 2 + (int16_t)GEOM_TO_INT(x);
+    s->y = SCR_HEIGHT / 2 - (int16_t)GEOM_TO_INT(z);
+}
+
+// ========== 高度场 ==========
+// Whether line 0 of the parallel lines o + l * across (l = 0 .. lines-1) is
+// nearer to the eye than the last one, so that front to back runs with l.
+// With perspective this is exact as long as the eye is off to one side of
+// all the lines.
+static inline bool camera_first_line_nearer(const Camera *cam, const Vertex3D *o,
+                                            const Vertex3D *across, int lines) {
+    const float ax = GEOM_TO_FLOAT(across->x), ay = GEOM_TO_FLOAT(across->y), az = GEOM_TO_FLOAT(across->z);
+    if (!cam->perspective) return ay >= 0;
+    // Position of the eye (0, -focal, 0) along across, in line steps
+    const float t = (-GEOM_TO_FLOAT(o->x) * ax - (cam->focal + GEOM_TO_FLOAT(o->y)) * ay -
+                     GEOM_TO_FLOAT(o->z) * az) / (ax * ax + ay * ay + az * az);
+    return t < 0.5f * (lines - 1);
+}
+
+// Length of a basis vector, for bounding spheres
+static inline float camera_vec_len(const Vertex3D *v) {
+    float x = GEOM_TO_FLOAT(v->x), y = GEOM_TO_FLOAT(v->y), z = GEOM_TO_FLOAT(v->z);
+    return sqrtf(x * x + y * y + z * z);
+}
+
+// Which grid lines of a height field to project. Line l (a grid row if
+// by_rows, else a column) is in view when its bounding sphere is; it is
+// projected when it or a neighbour is in view, since the segments across to
+// a line in view need both ends, and when it lies wholly in front of the
+// near plane.
+#define CAMERA_LINE_PROJECT 1
+#define CAMERA_LINE_IN_VIEW 2
+#define CAMERA_LINE_FRONT   4
+
+// Fills flags[0 .. lines-1] for a height field whose basis is in view-space
+// pixels. Returns false when nothing is in view.
+static inline bool camera_cull_heightfield(const Camera *cam, const HeightField *hf,
+                                           const HeightFieldBasis *basis, bool by_rows,
+                                           uint8_t *flags) {
+    const Vertex3D *across = by_rows ? &basis->a : &basis->b;
+    const Vertex3D *along = by_rows ? &basis->b : &basis->a;
+    const int lines = by_rows ? hf->rows : hf->cols;
+    const int points = by_rows ? hf->cols : hf->rows;
+
+    // Centre of line 0 at mid height, and the radius of one line
+    const float zmid = 0.5f * (hf->z_min + hf->z_max) / QCOEF_ONE;
+    const float half_along = 0.5f * (points - 1), half_lines = 0.5f * (lines - 1);
+    float cx = GEOM_TO_FLOAT(basis->o.x) + half_along * GEOM_TO_FLOAT(along->x) + zmid * GEOM_TO_FLOAT(basis->c.x);
+    float cy = GEOM_TO_FLOAT(basis->o.y) + half_along * GEOM_TO_FLOAT(along->y) + zmid * GEOM_TO_FLOAT(basis->c.y);
+    float cz = GEOM_TO_FLOAT(basis->o.z) + half_along * GEOM_TO_FLOAT(along->z) + zmid * GEOM_TO_FLOAT(basis->c.z);
+    const float r = half_along * camera_vec_len(along) +
+                    0.5f * (hf->z_max - hf->z_min) / QCOEF_ONE * camera_vec_len(&basis->c);
+    const float ax = GEOM_TO_FLOAT(across->x), ay = GEOM_TO_FLOAT(across->y), az = GEOM_TO_FLOAT(across->z);
+
+    // The whole field first
+    CullResult whole = camera_cull_sphere(cam, cx + half_lines * ax, cy + half_lines * ay,
+                                          cz + half_lines * az, r + half_lines * camera_vec_len(across));
+    if (whole == CULL_OUTSIDE) return false;
+    if (whole == CULL_INSIDE) {
+        memset(flags, CAMERA_LINE_PROJECT | CAMERA_LINE_IN_VIEW | CAMERA_LINE_FRONT, lines);
+        return true;
+    }
+
+    bool any = false;
+    for (int l = 0; l < lines; l++) {
+        flags[l] = camera_cull_sphere(cam, cx, cy, cz, r) <= CULL_PARTIAL ? CAMERA_LINE_IN_VIEW : 0;
+        any |= flags[l] != 0;
+        if (!cam->perspective || cy - r >= cam->near - cam->focal) flags[l] |= CAMERA_LINE_FRONT;
+        cx += ax;
+        cy += ay;
+        cz += az;
+    }
+    for (int l = 0; l < lines; l++) {
+        bool in_view = (flags[l] & CAMERA_LINE_IN_VIEW) ||
+                       (l > 0 && (flags[l - 1] & CAMERA_LINE_IN_VIEW)) ||
+                       (l + 1 < lines && (flags[l + 1] & CAMERA_LINE_IN_VIEW));
+        if (in_view && (flags[l] & CAMERA_LINE_FRONT)) flags[l] |= CAMERA_LINE_PROJECT;
+    }
+    return any;
+}
+
+#endif // CAMERA_H
@@ -0,0 +1,111 @@
+// Display lists: one frame recorded as clipped segments, filled polygons and
+// overlay commands
+// 显示列表：core1 把一帧记录成已裁剪的线段、填充多边形和文字/图形命令，
+// 由光栅化的一方（同一核或另一核）回放到帧缓冲区
+//
+#ifndef DISPLAY_LIST_H
+#define DISPLAY_LIST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "simple_gfx.h"
+
+// The 64x64 grid emits up to 8064 segments; bigger frames are split over
+// several lists
+#define DL_LINES_MAX 8192
+// The filled 64x64 grid has up to 3969 cells, a quad or two triangles each;
+// at 36 bytes per polygon it is split over several lists too. The hidden-line
+// surface records polygons only for the views the floating horizon does not
+// fit, as outlined cells painted in order. A small pool only splits those
+// frames over more lists (16 for 4000 cells instead of 4), at 9 KB per list
+// rather than 36 KB. See-through wireframe builds record no polygons.
+#if FILLED_SURFACES
+#define DL_POLYS_MAX 1024
+#elif HEIGHTFIELD_HIDDEN_LINES
+#define DL_POLYS_MAX 256
+#else
+#define DL_POLYS_MAX 16
+#endif
+#define DL_CMDS_MAX  16
+#define DL_TEXT_MAX  256
+
+typedef enum {
+    DL_CMD_TEXT,          // glyph run: text[arg], size
+    DL_CMD_RECT,          // x, y, w, h, filled
+    DL_CMD_CIRCLE,        // x, y, r = w, filled
+} DlCmdType;
+
+typedef struct {
+    uint8_t type;
+    uint8_t size;         // glyph scale, or filled for shapes
+    int16_t x, y, w, h;
+    uint16_t text;        // offset into DisplayList.text
+} DlCmd;
+
+typedef struct {
+    int16_t xy[4 * DL_LINES_MAX];     // segments as x0, y0, x1, y1
+    int num_lines;
+    GfxPoly polys[DL_POLYS_MAX];      // drawn before the segments
+    int num_polys;
+    DlCmd cmds[DL_CMDS_MAX];
+    int num_cmds;
+    char text[DL_TEXT_MAX];
+    int text_len;
+    bool end_of_frame;    // last list of its frame: present after drawing it
+} DisplayList;
+
+static inline void dl_reset(DisplayList *dl) {
+    dl->num_lines = 0;
+    dl->num_polys = 0;
+    dl->num_cmds = 0;
+    dl->text_len = 0;
+    dl->end_of_frame = false;
+}
+
+static inline DlCmd *dl_add_cmd(DisplayList *dl, DlCmdType type, int x, int y, int w, int h, int size) {
+    if (dl->num_cmds == DL_CMDS_MAX) return NULL;
+    DlCmd *cmd = &dl->cmds[dl->num_cmds++];
+    *cmd = (DlCmd){ type, size, x, y, w, h, 0 };
+    return cmd;
+}
+
+// Commands that do not fit are dropped
+static inline void dl_text(DisplayList *dl, int x, int y, const char *str, int size) {
+    int len = strlen(str) + 1;
+    if (dl->text_len + len > DL_TEXT_MAX) return;
+    DlCmd *cmd = dl_add_cmd(dl, DL_CMD_TEXT, x, y, 0, 0, size);
+    if (!cmd) return;
+    cmd->text = dl->text_len;
+    memcpy(dl->text + dl->text_len, str, len);
+    dl->text_len += len;
+}
+
+static inline void dl_rect(DisplayList *dl, int x, int y, int w, int h, bool filled) {
+    dl_add_cmd(dl, DL_CMD_RECT, x, y, w, h, filled);
+}
+
+static inline void dl_circle(DisplayList *dl, int x, int y, int r, bool filled) {
+    dl_add_cmd(dl, DL_CMD_CIRCLE, x, y, r, 0, filled);
+}
+
+// Play back the overlay commands (the polygons and segments are drawn by
+// the caller, whole or in bands)
+static inline void dl_draw_commands(unsigned char *buf, const DisplayList *dl) {
+    for (int i = 0; i < dl->num_cmds; i++) {
+        const DlCmd *cmd = &dl->cmds[i];
+        switch (cmd->type) {
+            case DL_CMD_TEXT:
+                gfx_draw_string(buf, cmd->x, cmd->y, dl->text + cmd->text, cmd->size);
+                break;
+            case DL_CMD_RECT:
+                gfx_draw_rect(buf, cmd->x, cmd->y, cmd->w, cmd->h, cmd->size);
+                break;
+            case DL_CMD_CIRCLE:
+                gfx_draw_circle(buf, cmd->x, cmd->y, cmd->w, cmd->size);
+                break;
+        }
+    }
+}
+
+#endif // DISPLAY_LIST_H
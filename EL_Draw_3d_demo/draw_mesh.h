@@ -1,9 +1,21 @@
+#ifndef DRAW_MESH_H
+#define DRAW_MESH_H
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include "el.h"
 #include "simple_gfx.h"
+#include "fast_math.h"
+#include "transform.h"
+#include "wire_mesh.h"
+#include "mesh_tables.h"
+#include "dual_core.h"
+#include "horizon.h"
+#include "shade.h"
+#include "camera.h"
+#include "surface_anim.h"
 #include "pico/time.h"
 
 
@@ -12,227 +24,761 @@
 #define CENTER_X      (SCREEN_WIDTH / 2)
 #define CENTER_Y      (SCREEN_HEIGHT / 2)
 
-#define GRID_SIZE 64     
-#define RANGE     10.0f   
+// Grid size and range are set by the generated height table
+// (cmake -DGRID_SIZE=N, see tools/gen_mesh_tables.py)
+#define GRID_SIZE PARABOLOID_GRID_SIZE
+#define RANGE     PARABOLOID_RANGE
 #define SCALE     160/RANGE     
 const uint16_t window_x = 8;
 
+// 1 = draw the surface with hidden lines removed (floating horizon),
+// 0 = see-through wireframe. Off by default: the horizon fits only 12-22% of
+// the views along the demo's rotation, the rest fall back to outlined cells,
+// and a hidden-line frame costs 2.6-4x a see-through one (see Readme.md;
+// cmake -DHEIGHTFIELD_HIDDEN_LINES=ON)
+#ifndef HEIGHTFIELD_HIDDEN_LINES
+#define HEIGHTFIELD_HIDDEN_LINES 0
+#endif
+
+// 1 = draw the height field and the models as flat shaded, dithered
+// surfaces instead of wireframes (cmake -DFILLED_SURFACES=ON)
+#ifndef FILLED_SURFACES
+#define FILLED_SURFACES 0
+#endif
+
+// Edges of closed wireframe models to draw: WIRE_CULL_NONE (see-through),
+// WIRE_CULL_BACK (hidden edges removed) or WIRE_CULL_SILHOUETTE (outline)
+#ifndef WIRE_CULL_MODE
+#define WIRE_CULL_MODE WIRE_CULL_BACK
+#endif
+
+// 1 = run the self-checks and benchmarks (check_*) once at boot, before the
+// first frame. They use the draw buffer and display list 0 as scratch.
+// (cmake -DSTARTUP_CHECKS=ON)
+#ifndef STARTUP_CHECKS
+#define STARTUP_CHECKS 0
+#endif
+
+// Decode of the int16 height table, which covers [PARABOLOID_Z_MIN, PARABOLOID_Z_MAX]
+#define PARABOLOID_Z_BIAS  ((PARABOLOID_Z_MAX + PARABOLOID_Z_MIN) / 2)
+#define PARABOLOID_Z_SCALE ((PARABOLOID_Z_MAX - PARABOLOID_Z_MIN) / 65534.0f)
+
+// Detail levels of the paraboloid, 0 = GRID_SIZE x GRID_SIZE (lod.h)
+static HeightField paraboloid[PARABOLOID_LODS];
+
+// Rippling surface on the same grids, animated by surface_anim.h: the
+// heights of the level in use are rewritten into ripple_z every frame
+#define RIPPLE_W        3.0f      // rad/s of the ripple
+#define RIPPLE_WAVE_KX  0.35f     // rad per world unit of the travelling wave
+#define RIPPLE_WAVE_KY  0.2f
+#define RIPPLE_WAVE_W   2.0f      // rad/s of the travelling wave
+static HeightField ripple[PARABOLOID_LODS];
+static int16_t ripple_z[GRID_SIZE * GRID_SIZE];
+static SurfaceAnim ripple_anim;
+static int ripple_level = -1;     // level bound to ripple_anim
+
+// Camera shared by all the demos (CAMERA_FOV_DEG, camera.h)
+static Camera camera;
 
-typedef struct {
-    float x, y, z;
-} Vertex3D;
 
-static void putpixel(unsigned char *buf, int x, int y, int c) {
-    if (x >= 0 && x < SCR_WIDTH && y >= 0 && y < SCR_HEIGHT) {
-        if (c) {
-            buf[SCR_STRIDE * y + x / 8] |= 1 << (x % 8);
-        } else {
-            buf[SCR_STRIDE * y + x / 8] &= ~(1 << (x % 8));
-        }
+float angle_x = 0.15f;
+float angle_y = 0.15f;
+float angle_z = 0.15f;
+float speed = 0.9f;       // rad/s about x, y and z turn 1.5 and 0.7 times as fast
+
+// Seconds between the last two frames (advance_angles())
+static float frame_dt;
+
+// Time spent transforming and projecting in the last frame, for diagnostics
+static uint32_t last_transform_us;
+// Work time of the last frame: core1 recording it (and rasterizing, outside
+// pipeline mode) or core0 rasterizing the one before, whichever took longer.
+// Waiting and pacing are not included; this is what the LOD governor holds
+// to the frame budget.
+static uint32_t last_frame_us;
+
+
+void draw_ui_elements(DisplayList *dl, const char *info);
+
+// Rotation with the projection scale folded in, so that the height-field
+// basis comes out in view-space pixels
+static inline void heightfield_view_basis(const HeightField *hf, const Mat3 *m, HeightFieldBasis *basis) {
+    Mat3 ms = *m;
+    for (int r = 0; r < 3; r++) {
+        for (int k = 0; k < 3; k++) ms.m[r][k] *= SCALE;
     }
+    heightfield_basis(hf, &ms, basis);
 }
 
-
-static void draw_line(unsigned char *buf, int x0, int y0, int x1, int y1) {
-    int dx = abs(x1 - x0);
-    int dy = abs(y1 - y0);
-    int sx = (x0 < x1) ? 1 : -1;
-    int sy = (y0 < y1) ? 1 : -1;
-    int err = dx - dy;
-    
-    while (1) {
-        putpixel(buf, x0, y0, 1);
-        
-        if (x0 == x1 && y0 == y1) break;
-        
-        int e2 = 2 * err;
-        if (e2 > -dy) {
-            err -= dy;
-            x0 += sx;
-        }
-        if (e2 < dx) {
-            err += dx;
-            y0 += sy;
+// Rotate, scale and project row i of a height field in one pass. The basis
+// is already scaled to pixels, so each vertex is origin + i*A + j*B + z*C
+// truncated to int; the depth component is only computed for the
+// perspective divide.
+static inline void project_heightfield_row(const HeightField *hf, const HeightFieldBasis *basis,
+                                           const Camera *cam, int i, ScreenVertex *screen,
+                                           uint8_t *outcode) {
+    const geom_t bx = basis->b.x, by = basis->b.y, bz = basis->b.z;
+    const geom_t cx = basis->c.x, cy = basis->c.y, cz = basis->c.z;
+    geom_t px = basis->o.x + i * basis->a.x;
+    geom_t py = basis->o.y + i * basis->a.y;
+    geom_t pz = basis->o.z + i * basis->a.z;
+    const int16_t *zr = hf->z ? hf->z + i * hf->cols : NULL;
+
+    for (int j = 0; j < hf->cols; j++) {
+        geom_t x = px, y = py, z = pz;
+        if (zr) {
+            x += QCOEF_MUL(zr[j], cx);
+            z += QCOEF_MUL(zr[j], cz);
+            if (cam->perspective) y += QCOEF_MUL(zr[j], cy);
         }
+        camera_project(cam, x, y, z, &screen[j]);
+        outcode[j] = gfx_outcode(screen[j].x, screen[j].y);
+        px += bx;
+        py += by;
+        pz += bz;
     }
 }
 
-static void clear_screen(unsigned char *buf) {
-    memset(buf, 0, SCR_STRIDE * SCR_HEIGHT);
+// Fused transform/project pass for height fields. Rows are streamed through
+// a two-row ring of screen coordinates: once row i is projected its row
+// segments are emitted, plus the column segments back to row i-1, so only
+// O(cols) vertex data is kept. Grid topology is implicit (行线+列线).
+// Rows out of view are skipped (camera_cull_heightfield()) and segments
+// entirely off one side of the screen are rejected here already.
+void emit_heightfield(GfxLineBatch *batch, const HeightField *hf, const Mat3 *m, const Camera *cam) {
+    static ScreenVertex ring[2][GRID_SIZE];
+    static uint8_t ring_outcode[2][GRID_SIZE];
+    static uint8_t row_flags[GRID_SIZE];
+
+    HeightFieldBasis basis;
+    heightfield_view_basis(hf, m, &basis);
+    const int rows = hf->rows < GRID_SIZE ? hf->rows : GRID_SIZE;
+    if (!camera_cull_heightfield(cam, hf, &basis, true, row_flags)) return;
+
+    const int cols = hf->cols < GRID_SIZE ? hf->cols : GRID_SIZE;
+    for (int i = 0; i < rows; i++) {
+        if (!(row_flags[i] & CAMERA_LINE_PROJECT)) continue;
+        ScreenVertex *row = ring[i & 1];
+        uint8_t *row_oc = ring_outcode[i & 1];
+        const ScreenVertex *prev = ring[(i - 1) & 1];
+        const uint8_t *prev_oc = ring_outcode[(i - 1) & 1];
+        const bool cross = i > 0 && (row_flags[i - 1] & CAMERA_LINE_PROJECT);
+
+        project_heightfield_row(hf, &basis, cam, i, row, row_oc);
+
+        for (int j = 0; j < cols; j++) {
+            if (j < cols - 1 && !(row_oc[j] & row_oc[j + 1])) {
+                gfx_batch_add(batch, row[j].x, row[j].y, row[j + 1].x, row[j + 1].y);
+            }
+            if (cross && !(prev_oc[j] & row_oc[j])) {
+                gfx_batch_add(batch, prev[j].x, prev[j].y, row[j].x, row[j].y);
+            }
+        }
+    }
 }
 
+// Project the n vertices (i0 + k*di, j0 + k*dj) of a height field, i.e. one
+// grid row (di = 0, dj = 1) or one grid column (di = 1, dj = 0)
+static inline void project_heightfield_line(const HeightField *hf, const HeightFieldBasis *basis,
+                                            const Camera *cam, int i0, int j0, int di, int dj, int n,
+                                            ScreenVertex *screen) {
+    const geom_t sx = di * basis->a.x + dj * basis->b.x;
+    const geom_t sy = di * basis->a.y + dj * basis->b.y;
+    const geom_t sz = di * basis->a.z + dj * basis->b.z;
+    const geom_t cx = basis->c.x, cy = basis->c.y, cz = basis->c.z;
+    geom_t px = basis->o.x + i0 * basis->a.x + j0 * basis->b.x;
+    geom_t py = basis->o.y + i0 * basis->a.y + j0 * basis->b.y;
+    geom_t pz = basis->o.z + i0 * basis->a.z + j0 * basis->b.z;
+    const int16_t *zp = hf->z ? hf->z + i0 * hf->cols + j0 : NULL;
+    const int zstep = di * hf->cols + dj;
+
+    for (int k = 0; k < n; k++) {
+        geom_t x = px, y = py, z = pz;
+        if (zp) {
+            x += QCOEF_MUL(zp[k * zstep], cx);
+            z += QCOEF_MUL(zp[k * zstep], cz);
+            if (cam->perspective) y += QCOEF_MUL(zp[k * zstep], cy);
+        }
+        camera_project(cam, x, y, z, &screen[k]);
+        px += sx;
+        py += sy;
+        pz += sz;
+    }
+}
 
-static Vertex3D paraboloid_vertices[GRID_SIZE * GRID_SIZE];
-static Vertex3D base_vertices[GRID_SIZE * GRID_SIZE];
-static int edge_count;
-static int edges[2 * GRID_SIZE * (GRID_SIZE - 1) * 2][2]; // 行线+列线
-static Vertex3D rotated_paraboloid[GRID_SIZE * GRID_SIZE];
-static Vertex3D rotated_base[GRID_SIZE * GRID_SIZE];
-
-
-float angle_x = 0.15f;
-float angle_y = 0.15f;
-float angle_z = 0.15f;
-float speed = 0.03f;
-
-
-void draw_ui_elements(unsigned char *buffer);
+// How well grid lines along (di, dj) suit the floating horizon. Lines are
+// stepped across in depth order, so the depth step between neighbouring lines
+// (across = the other grid direction) must outweigh what height differences
+// add; and every line must run one way along the screen axis the horizon is
+// kept for, i.e. the step along the line must outweigh the height term on
+// that axis too. Both margins are > 0 when the order is exact.
+typedef struct {
+    float depth_margin;
+    bool transposed;              // horizon per screen row (lines run vertically)
+} HorizonFit;
+
+static HorizonFit horizon_fit(const HeightFieldBasis *basis, const Vertex3D *along,
+                              const Vertex3D *across, int dz_along, int dz_across) {
+    const float cx = fabsf(GEOM_TO_FLOAT(basis->c.x)) / QCOEF_ONE * dz_along;
+    const float cy = fabsf(GEOM_TO_FLOAT(basis->c.y)) / QCOEF_ONE * dz_across;
+    const float cz = fabsf(GEOM_TO_FLOAT(basis->c.z)) / QCOEF_ONE * dz_along;
+    const float mono_x = fabsf(GEOM_TO_FLOAT(along->x)) - cx;
+    const float mono_y = fabsf(GEOM_TO_FLOAT(along->z)) - cz;
+
+    HorizonFit fit;
+    fit.transposed = mono_y > mono_x;
+    fit.depth_margin = fabsf(GEOM_TO_FLOAT(across->y)) - cy;
+    if ((fit.transposed ? mono_y : mono_x) <= 0) fit.depth_margin = 0;
+    return fit;
+}
 
-float calculate_zx(float u, float v) {
-    float r = sqrt(u * u + v * v); 
-    
-    if (r == 0.0f) {
-        return 1.0f;  
-    } else {
-        return 5*sin(r) / r;
+// Height field as filled, flat shaded triangles, two per grid cell, drawn
+// back to front: rows from the far side, in each row the cells from the far
+// side, in each cell the farther triangle first. Cells whose two triangles
+// get the same shade (most of them) are drawn as one quad. Rows are streamed
+// through the same two-row ring as emit_heightfield(). Normals are taken in model
+// space from the height differences, where the light is brought once per
+// frame (shade_frame_model()).
+// With outlined set the cells are drawn as black quads with all four edges
+// outlined instead: painted in the same order they remove hidden lines in any
+// view, at about twice the line work of emit_heightfield_hidden().
+static void emit_heightfield_cells(GfxLineBatch *batch, const HeightField *hf, const Mat3 *m,
+                                   const Camera *cam, bool outlined) {
+    static ScreenVertex ring[2][GRID_SIZE];
+    static uint8_t ring_outcode[2][GRID_SIZE];
+    static uint8_t row_flags[GRID_SIZE];
+
+    HeightFieldBasis basis;
+    heightfield_view_basis(hf, m, &basis);
+    const ShadeFrame sf = shade_frame_model(m);
+    const int rows = hf->rows < GRID_SIZE ? hf->rows : GRID_SIZE;
+    const int cols = hf->cols < GRID_SIZE ? hf->cols : GRID_SIZE;
+    if (!camera_cull_heightfield(cam, hf, &basis, true, row_flags)) return;
+
+    // Step rows and columns away from the far side
+    const int di = camera_first_line_nearer(cam, &basis.o, &basis.a, rows) ? -1 : 1;
+    const int dj = camera_first_line_nearer(cam, &basis.o, &basis.b, cols) ? -1 : 1;
+    const int i_first = di > 0 ? 0 : rows - 1;
+    const int j_first = dj > 0 ? 0 : cols - 1;
+    // Triangle (00, 10, 11) holds corner 10, (00, 11, 01) corner 01
+    const bool lower_first = basis.a.y > basis.b.y;
+
+    const float hx = GEOM_TO_FLOAT(hf->dx), hy = GEOM_TO_FLOAT(hf->dy), hs = hf->z_scale;
+    for (int n = 0; n < rows; n++) {
+        const int i = i_first + n * di;
+        if (!(row_flags[i] & CAMERA_LINE_PROJECT)) continue;
+        ScreenVertex *row = ring[n & 1];
+        uint8_t *row_oc = ring_outcode[n & 1];
+        const ScreenVertex *prev = ring[(n - 1) & 1];
+        const uint8_t *prev_oc = ring_outcode[(n - 1) & 1];
+
+        project_heightfield_row(hf, &basis, cam, i, row, row_oc);
+        if (n == 0 || !(row_flags[i - di] & CAMERA_LINE_PROJECT)) continue;
+
+        // Grid rows i0 and i0 + 1 of the cells between this row and the last
+        const int i0 = di > 0 ? i - 1 : i;
+        const ScreenVertex *r0 = di > 0 ? prev : row, *r1 = di > 0 ? row : prev;
+        const uint8_t *o0 = di > 0 ? prev_oc : row_oc, *o1 = di > 0 ? row_oc : prev_oc;
+        for (int k = 0; k < cols - 1; k++) {
+            const int j0 = dj > 0 ? j_first + k : j_first - k - 1;
+            if (o0[j0] & o0[j0 + 1] & o1[j0] & o1[j0 + 1]) continue;
+
+            const ScreenVertex *s00 = &r0[j0], *s01 = &r0[j0 + 1], *s10 = &r1[j0], *s11 = &r1[j0 + 1];
+            if (outlined) {
+                gfx_batch_add_quad_outlined(batch, s00->x, s00->y, s10->x, s10->y, s11->x, s11->y,
+                                            s01->x, s01->y, 0, 0xF);
+                continue;
+            }
+
+            float h00 = 0, h01 = 0, h10 = 0, h11 = 0;
+            if (hf->z) {
+                const int16_t *z0 = hf->z + i0 * hf->cols + j0, *z1 = z0 + hf->cols;
+                h00 = hs * z0[0];
+                h01 = hs * z0[1];
+                h10 = hs * z1[0];
+                h11 = hs * z1[1];
+            }
+            const int lower = shade_level(&sf, -hy * (h10 - h00), -hx * (h11 - h10), hx * hy);
+            const int upper = shade_level(&sf, -hy * (h11 - h01), -hx * (h01 - h00), hx * hy);
+            if (lower == upper) {
+                gfx_batch_add_quad(batch, s00->x, s00->y, s10->x, s10->y, s11->x, s11->y,
+                                   s01->x, s01->y, lower);
+                continue;
+            }
+            for (int t = 0; t < 2; t++) {
+                if ((t == 0) == lower_first) {
+                    gfx_batch_add_tri(batch, s00->x, s00->y, s10->x, s10->y, s11->x, s11->y, lower);
+                } else {
+                    gfx_batch_add_tri(batch, s00->x, s00->y, s11->x, s11->y, s01->x, s01->y, upper);
+                }
+            }
+        }
     }
 }
 
+void emit_heightfield_filled(GfxLineBatch *batch, const HeightField *hf, const Mat3 *m, const Camera *cam) {
+    emit_heightfield_cells(batch, hf, m, cam, false);
+}
 
-void rotate_vertex(float x, float y, float z, float* out_x, float* out_y, float* out_z) {
-    float cos_y = cosf(angle_y), sin_y = sinf(angle_y);
-    float x1 = x * cos_y - z * sin_y;
-    float z1 = x * sin_y + z * cos_y;
-    float y1 = y;
-
-    float cos_x = cosf(angle_x), sin_x = sinf(angle_x);
-    float y2 = y1 * cos_x - z1 * sin_x;
-    float z2 = y1 * sin_x + z1 * cos_x;
-    float x2 = x1;
+// Height field with hidden lines removed. The viewer looks along +y, so the
+// rotated y is depth. Grid rows or columns, whichever suits better (see
+// horizon_fit()), are taken front to back; each line's own segments and the
+// cross segments back to the line before it are clipped against the
+// floating horizon, then the line is committed. When neither direction fits
+// (views steep onto the surface, or lines folding on screen) the cells are
+// painted back to front instead, each blanked and then outlined
+// (emit_heightfield_cells()).
+void emit_heightfield_hidden(GfxLineBatch *batch, const HeightField *hf, const Mat3 *m, const Camera *cam) {
+    static ScreenVertex ring[2][GRID_SIZE];
+    static uint8_t line_flags[GRID_SIZE];
+    static Horizon horizon;
+
+    HeightFieldBasis basis;
+    heightfield_view_basis(hf, m, &basis);
+
+    const HorizonFit fit_rows = horizon_fit(&basis, &basis.b, &basis.a, hf->dz_j, hf->dz_i);
+    const HorizonFit fit_cols = horizon_fit(&basis, &basis.a, &basis.b, hf->dz_i, hf->dz_j);
+    if (fit_rows.depth_margin <= 0 && fit_cols.depth_margin <= 0) {
+        emit_heightfield_cells(batch, hf, m, cam, true);
+        return;
+    }
 
-    float cos_z = cosf(angle_z), sin_z = sinf(angle_z);
-    float x3 = x2 * cos_z - y2 * sin_z;
-    float y3 = x2 * sin_z + y2 * cos_z;
-    float z3 = z2;
+    const bool by_rows = fit_rows.depth_margin >= fit_cols.depth_margin;
+    int lines = by_rows ? hf->rows : hf->cols;
+    int points = by_rows ? hf->cols : hf->rows;
+    if (lines > GRID_SIZE) lines = GRID_SIZE;
+    if (points > GRID_SIZE) points = GRID_SIZE;
+    if (!camera_cull_heightfield(cam, hf, &basis, by_rows, line_flags)) return;
+    const bool forward = camera_first_line_nearer(cam, &basis.o, by_rows ? &basis.a : &basis.b, lines);
+    const int first = forward ? 0 : lines - 1;
+    const int dir = forward ? 1 : -1;
+
+    horizon_reset(&horizon, by_rows ? fit_rows.transposed : fit_cols.transposed);
+    for (int n = 0; n < lines; n++) {
+        const int l = first + n * dir;
+        if (!(line_flags[l] & CAMERA_LINE_PROJECT)) continue;
+        ScreenVertex *cur = ring[n & 1];
+        const ScreenVertex *prev = ring[(n - 1) & 1];
+        const bool cross = n > 0 && (line_flags[l - dir] & CAMERA_LINE_PROJECT);
+
+        if (by_rows) {
+            project_heightfield_line(hf, &basis, cam, l, 0, 0, 1, points, cur);
+        } else {
+            project_heightfield_line(hf, &basis, cam, 0, l, 1, 0, points, cur);
+        }
 
-    *out_x = x3;
-    *out_y = y3;
-    *out_z = z3;
+        for (int k = 0; k < points; k++) {
+            if (k < points - 1) {
+                horizon_segment(&horizon, batch, cur[k].x, cur[k].y, cur[k + 1].x, cur[k + 1].y);
+            }
+            if (cross) {
+                horizon_segment(&horizon, batch, prev[k].x, prev[k].y, cur[k].x, cur[k].y);
+            }
+        }
+        horizon_commit(&horizon);
+    }
 }
 
-
-void project_to_screen(float x, float y, float z, int16_t* screen_x, int16_t* screen_y) {
-    *screen_x = CENTER_X + (int16_t)(x * SCALE);
-    *screen_y = CENTER_Y - (int16_t)(z * SCALE);
+// The height-field renderer selected by FILLED_SURFACES and
+// HEIGHTFIELD_HIDDEN_LINES
+static inline void emit_heightfield_surface(GfxLineBatch *batch, const HeightField *hf,
+                                            const Mat3 *rot, const Camera *cam) {
+#if FILLED_SURFACES
+    emit_heightfield_filled(batch, hf, rot, cam);
+#elif HEIGHTFIELD_HIDDEN_LINES
+    emit_heightfield_hidden(batch, hf, rot, cam);
+#else
+    emit_heightfield(batch, hf, rot, cam);
+#endif
 }
 
+// The heights (5 * sinc(r) over the grid, at every detail level) are const
+// tables generated at build time, so this only fills in the grid
+// descriptions and sets up the camera
 void init_mesh() {
-    for (int i = 0; i < GRID_SIZE; i++) {
-        for (int j = 0; j < GRID_SIZE; j++) {
-            float x = -RANGE + (2.0f * RANGE) * i / (GRID_SIZE - 1);
-            float y = -RANGE + (2.0f * RANGE) * j / (GRID_SIZE - 1);
-            float z_paraboloid = calculate_zx(x,y);
-            float z_base = -2.0f;
-
-            int idx = i * GRID_SIZE + j;
-            paraboloid_vertices[idx] = (Vertex3D){x, y, z_paraboloid};
-            base_vertices[idx] = (Vertex3D){x, y, z_base};
+    for (int l = 0; l < PARABOLOID_LODS; l++) {
+        const int n = paraboloid_lod_size[l];
+        const float step = (2.0f * RANGE) / (n - 1);
+
+        paraboloid[l] = (HeightField){
+            .rows = n, .cols = n,
+            .x0 = GEOM_FROM_FLOAT(-RANGE), .y0 = GEOM_FROM_FLOAT(-RANGE), .z0 = GEOM_FROM_FLOAT(PARABOLOID_Z_BIAS),
+            .dx = GEOM_FROM_FLOAT(step), .dy = GEOM_FROM_FLOAT(step),
+            .z = paraboloid_lod_heights[l], .z_scale = PARABOLOID_Z_SCALE,
+        };
+        heightfield_z_range(&paraboloid[l]);
+        heightfield_z_steps(&paraboloid[l]);
+
+        // Heights filled in by surface_anim_bind()
+        ripple[l] = paraboloid[l];
+        ripple[l].z0 = 0;
+        ripple[l].z = NULL;
+        ripple[l].z_scale = RIPPLE_Z_SCALE;
+    }
+    ripple_anim = (SurfaceAnim){
+        .ripple_w = RIPPLE_W,
+        .wave_amp = (int16_t)(RIPPLE_WAVE_PEAK / RIPPLE_Z_SCALE),
+        .wave_kx = RIPPLE_WAVE_KX, .wave_ky = RIPPLE_WAVE_KY, .wave_w = RIPPLE_WAVE_W,
+    };
+    camera_init(&camera, CAMERA_FOV_DEG, CAMERA_NEAR);
+}
+
+#if STARTUP_CHECKS
+// Run the paraboloid through both numeric backends and report the largest
+// projected difference in pixels plus the kernel time for one frame's mesh.
+#define GEOM_CHECK_CHUNK 64
+void check_geom_backends() {
+    static Vertex3Df in_f[GEOM_CHECK_CHUNK], out_f[GEOM_CHECK_CHUNK];
+    static Vertex3Dq in_q[GEOM_CHECK_CHUNK], out_q[GEOM_CHECK_CHUNK];
+    const int32_t scale_q = Q16_FROM_FLOAT(SCALE);
+
+    Mat3 rot;
+    mat3_from_euler(&rot, angle_x, angle_y, angle_z);
+
+    int max_err = 0;
+    for (int base = 0; base < GRID_SIZE * GRID_SIZE; base += GEOM_CHECK_CHUNK) {
+        for (int k = 0; k < GEOM_CHECK_CHUNK; k++) {
+            int idx = base + k;
+            Vertex3D v = heightfield_vertex(&paraboloid[0], idx / GRID_SIZE, idx % GRID_SIZE);
+            in_f[k] = (Vertex3Df){ GEOM_TO_FLOAT(v.x), GEOM_TO_FLOAT(v.y), GEOM_TO_FLOAT(v.z) };
+            in_q[k] = (Vertex3Dq){ Q16_FROM_FLOAT(in_f[k].x), Q16_FROM_FLOAT(in_f[k].y), Q16_FROM_FLOAT(in_f[k].z) };
+        }
+        transform_vertices_f(in_f, out_f, GEOM_CHECK_CHUNK, &rot);
+        transform_vertices_q(in_q, out_q, GEOM_CHECK_CHUNK, &rot);
+
+        for (int k = 0; k < GEOM_CHECK_CHUNK; k++) {
+            int ex = abs((int)(out_f[k].x * SCALE) - Q16_TO_INT(Q16_MUL(out_q[k].x, scale_q)));
+            int ez = abs((int)(out_f[k].z * SCALE) - Q16_TO_INT(Q16_MUL(out_q[k].z, scale_q)));
+            if (ex > max_err) max_err = ex;
+            if (ez > max_err) max_err = ez;
         }
     }
 
-    edge_count = 0;
+    // Same number of vertex transforms as one frame of the paraboloid
+    uint32_t t0 = time_us_32();
+    for (int r = 0; r < GRID_SIZE * GRID_SIZE / GEOM_CHECK_CHUNK; r++) {
+        transform_vertices_f(in_f, out_f, GEOM_CHECK_CHUNK, &rot);
+    }
+    uint32_t t1 = time_us_32();
+    for (int r = 0; r < GRID_SIZE * GRID_SIZE / GEOM_CHECK_CHUNK; r++) {
+        transform_vertices_q(in_q, out_q, GEOM_CHECK_CHUNK, &rot);
+    }
+    uint32_t t2 = time_us_32();
 
+    printf("Geometry backend: %s, fixed vs float max error %d px, "
+           "per frame float %d us, fixed %d us\n",
+           GEOM_FIXED_POINT ? "fixed" : "float", max_err, t1 - t0, t2 - t1);
+}
+#endif // STARTUP_CHECKS
+
+#if STARTUP_CHECKS
+// Time one frame's worth of perspective divides (one per paraboloid vertex)
+// through the camera's fast reciprocal and through a plain divide, and
+// report the largest relative difference
+void check_camera() {
+    static geom_t depth[GRID_SIZE];
     for (int j = 0; j < GRID_SIZE; j++) {
-        for (int i = 0; i < GRID_SIZE - 1; i++) {
-            int idx1 = i + j * GRID_SIZE;
-            int idx2 = i + 1 + j * GRID_SIZE;
-            edges[edge_count][0] = idx1;
-            edges[edge_count][1] = idx2;
-            edge_count++;
-        }
+        depth[j] = GEOM_FROM_FLOAT(-200.0f + 400.0f * j / GRID_SIZE);
+    }
+    if (!camera.perspective) {
+        printf("Camera: orthographic\n");
+        return;
     }
 
+    volatile geom_t sink = 0;
+    uint32_t t0 = time_us_32();
+    for (int i = 0; i < GRID_SIZE; i++) {
+        for (int j = 0; j < GRID_SIZE; j++) sink += camera_depth_scale(&camera, depth[j]);
+    }
+    uint32_t t1 = time_us_32();
     for (int i = 0; i < GRID_SIZE; i++) {
-        for (int j = 0; j < GRID_SIZE - 1; j++) {
-            int idx1 = i + j * GRID_SIZE;
-            int idx2 = i + (j + 1) * GRID_SIZE;
-            edges[edge_count][0] = idx1;
-            edges[edge_count][1] = idx2;
-            edge_count++;
+        for (int j = 0; j < GRID_SIZE; j++) {
+#if GEOM_FIXED_POINT
+            sink += (int32_t)(((int64_t)camera.focal_g << 16) / (camera.focal_g + depth[j]));
+#else
+            sink += camera.focal / (camera.focal + depth[j]);
+#endif
         }
     }
-}
+    uint32_t t2 = time_us_32();
 
-void draw_frame() {
+    float max_err = 0.0f;
+    for (int j = 0; j < GRID_SIZE; j++) {
+        float exact = camera.focal / (camera.focal + GEOM_TO_FLOAT(depth[j]));
+        float err = fabsf(GEOM_TO_FLOAT(camera_depth_scale(&camera, depth[j])) / exact - 1.0f);
+        if (err > max_err) max_err = err;
+    }
+    printf("Camera: fov %d, focal %.1f px, divides per frame fast %d us, plain %d us, max rel error %.1e\n",
+           CAMERA_FOV_DEG, camera.focal, t1 - t0, t2 - t1, max_err);
+}
+#endif // STARTUP_CHECKS
 
-    unsigned char *buffer = el_get_draw_buffer();
-    clear_screen(buffer);
+#if STARTUP_CHECKS
+// Scratch batches of check_surface_anim() are thrown away when full
+static void discard_batch(GfxLineBatch *batch) {
+    batch->count = 0;
+    batch->poly_count = 0;
+}
 
-    for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
-        float rx, ry, rz;
-        rotate_vertex(
-            paraboloid_vertices[i].x,
-            paraboloid_vertices[i].y,
-            paraboloid_vertices[i].z,
-            &rx, &ry, &rz
-        );
-        rotated_paraboloid[i] = (Vertex3D){rx, ry, rz};
+// Cost of the animated full-detail surface against the static one: the
+// height update alone and update plus emit, recorded into display list 0
+// (free before the first frame) and thrown away
+#define ANIM_CHECK_FRAMES 8
+
+void check_surface_anim() {
+    Mat3 rot;
+    mat3_from_euler(&rot, angle_x, angle_y, angle_z);
+    DisplayList *dl = &display_lists[0];
+    GfxLineBatch batch = {
+        .xy = dl->xy, .capacity = DL_LINES_MAX, .flush = discard_batch,
+        .polys = dl->polys, .poly_capacity = DL_POLYS_MAX,
+    };
+
+    surface_anim_bind(&ripple_anim, &ripple[0], ripple_z, ripple_lod_modes[0],
+                      (int16_t)(RIPPLE_PEAK / RIPPLE_Z_SCALE + 0.5f));
+    ripple_level = 0;
+
+    uint32_t t0 = time_us_32();
+    for (int f = 0; f < ANIM_CHECK_FRAMES; f++) {
+        emit_heightfield_surface(&batch, &paraboloid[0], &rot, &camera);
+        discard_batch(&batch);
     }
-
-    for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
-        float rx, ry, rz;
-        rotate_vertex(
-            base_vertices[i].x,
-            base_vertices[i].y,
-            base_vertices[i].z,
-            &rx, &ry, &rz
-        );
-        rotated_base[i] = (Vertex3D){rx, ry, rz};
+    uint32_t t1 = time_us_32();
+    for (int f = 0; f < ANIM_CHECK_FRAMES; f++) surface_anim_update(&ripple_anim, 1.0f / 60);
+    uint32_t t2 = time_us_32();
+    for (int f = 0; f < ANIM_CHECK_FRAMES; f++) {
+        surface_anim_update(&ripple_anim, 1.0f / 60);
+        emit_heightfield_surface(&batch, &ripple[0], &rot, &camera);
+        discard_batch(&batch);
     }
+    uint32_t t3 = time_us_32();
 
-    for (int i = 0; i < edge_count; i++) {
-        int v1_idx = edges[i][0];
-        int v2_idx = edges[i][1];
+    const uint32_t t_static = (t1 - t0) / ANIM_CHECK_FRAMES, t_anim = (t3 - t2) / ANIM_CHECK_FRAMES;
+    printf("Surface anim %dx%d: height update %d us, frame static %d us, animated %d us (x%.2f)\n",
+           ripple[0].rows, ripple[0].cols, (t2 - t1) / ANIM_CHECK_FRAMES, t_static, t_anim,
+           t_static ? (float)t_anim / t_static : 0.0f);
+}
+#endif // STARTUP_CHECKS
 
-        if (v1_idx >= GRID_SIZE * GRID_SIZE || v2_idx >= GRID_SIZE * GRID_SIZE) continue;
+#if STARTUP_CHECKS
+// Per-pixel Bresenham with a bounds-checked byte write per pixel, the
+// rasterizer used before gfx_draw_line_unclipped(); kept as the reference
+static void line_reference(unsigned char *buf, int x0, int y0, int x1, int y1) {
+    int dx = abs(x1 - x0);
+    int dy = abs(y1 - y0);
+    int sx = (x0 < x1) ? 1 : -1;
+    int sy = (y0 < y1) ? 1 : -1;
+    int err = dx - dy;
 
-        int16_t x1, y1, x2, y2;
+    while (1) {
+        gfx_set_pixel(buf, x0, y0, true);
+        if (x0 == x1 && y0 == y1) break;
+        int e2 = 2 * err;
+        if (e2 > -dy) {
+            err -= dy;
+            x0 += sx;
+        }
+        if (e2 < dx) {
+            err += dx;
+            y0 += sy;
+        }
+    }
+}
 
-        project_to_screen(
-            rotated_paraboloid[v1_idx].x,
-            rotated_paraboloid[v1_idx].y,
-            rotated_paraboloid[v1_idx].z,
-            &x1, &y1
-        );
-        project_to_screen(
-            rotated_paraboloid[v2_idx].x,
-            rotated_paraboloid[v2_idx].y,
-            rotated_paraboloid[v2_idx].z,
-            &x2, &y2
-        );
+// Check the run-based rasterizer against the reference on random lines (same
+// pixel count and every reference pixel set) and report pixels/us of both.
+// Uses the draw buffer as scratch, before the first frame.
+#define LINE_CHECK_COUNT 200
+#define LINE_BENCH_COUNT 2000
+void check_line_raster() {
+    unsigned char *buf = el_get_draw_buffer();
+    const uint32_t *words = (const uint32_t *)buf;
+    uint32_t seed = 12345;
+    int mismatches = 0;
+
+    for (int n = 0; n < LINE_CHECK_COUNT; n++) {
+        seed = seed * 1664525u + 1013904223u;
+        int x0 = (seed >> 8) % SCR_WIDTH, y0 = (seed >> 20) % SCR_HEIGHT;
+        seed = seed * 1664525u + 1013904223u;
+        int x1 = (seed >> 8) % SCR_WIDTH, y1 = (seed >> 20) % SCR_HEIGHT;
+        if (n & 1) {
+            // Every other line short, for the per-pixel path
+            x1 = abs(x0 + (int)((seed >> 8) % 31) - 15) % SCR_WIDTH;
+            y1 = abs(y0 + (int)((seed >> 20) % 31) - 15) % SCR_HEIGHT;
+        }
 
-        if (x1 < 0 || x1 >= SCREEN_WIDTH || y1 < 0 || y1 >= SCREEN_HEIGHT) continue;
-        if (x2 < 0 || x2 >= SCREEN_WIDTH || y2 < 0 || y2 >= SCREEN_HEIGHT) continue;
+        gfx_clear(buf);
+        gfx_draw_line_unclipped(buf, x0, y0, x1, y1);
+        int set = 0;
+        for (int w = 0; w < SCR_STRIDE_WORDS * SCR_HEIGHT; w++) {
+            set += __builtin_popcount(words[w]);
+        }
 
-        draw_line(buffer, x1, y1, x2, y2);
+        // Walk the reference line, every pixel must already be set
+        int pixels = 0;
+        int dx = abs(x1 - x0), dy = abs(y1 - y0);
+        int sx = (x0 < x1) ? 1 : -1, sy = (y0 < y1) ? 1 : -1;
+        int err = dx - dy, x = x0, y = y0;
+        while (1) {
+            if (!gfx_get_pixel(buf, x, y)) set = -1;
+            pixels++;
+            if (x == x1 && y == y1) break;
+            int e2 = 2 * err;
+            if (e2 > -dy) { err -= dy; x += sx; }
+            if (e2 < dx) { err += dx; y += sy; }
+        }
+        if (set != pixels) mismatches++;
     }
-    
-    draw_ui_elements(buffer);
-    
-    angle_x += speed;
+
+    printf("Line raster: %d/%d lines mismatch\n", mismatches, LINE_CHECK_COUNT);
+
+    // Same random line set through both rasterizers, for mesh-like segments
+    // (ends up to 24 px apart) and for short ones (up to 8 px, the per-pixel
+    // path)
+    static const int reach[2] = { 24, 8 };
+    int16_t lines[4 * 64];
+    for (int r = 0; r < 2; r++) {
+        uint32_t pixels = 0, t_ref = 0, t_run = 0;
+        for (int batch = 0; batch < LINE_BENCH_COUNT / 64; batch++) {
+            for (int k = 0; k < 64; k++) {
+                seed = seed * 1664525u + 1013904223u;
+                lines[4 * k] = (seed >> 8) % SCR_WIDTH;
+                lines[4 * k + 1] = (seed >> 20) % SCR_HEIGHT;
+                seed = seed * 1664525u + 1013904223u;
+                lines[4 * k + 2] = abs(lines[4 * k] + (int)((seed >> 8) % (2 * reach[r] + 1)) - reach[r]) % SCR_WIDTH;
+                lines[4 * k + 3] = abs(lines[4 * k + 1] + (int)((seed >> 20) % (2 * reach[r] + 1)) - reach[r]) % SCR_HEIGHT;
+                int dx = abs(lines[4 * k + 2] - lines[4 * k]), dy = abs(lines[4 * k + 3] - lines[4 * k + 1]);
+                pixels += (dx > dy ? dx : dy) + 1;
+            }
+            uint32_t t0 = time_us_32();
+            for (int k = 0; k < 64; k++) {
+                line_reference(buf, lines[4 * k], lines[4 * k + 1], lines[4 * k + 2], lines[4 * k + 3]);
+            }
+            uint32_t t1 = time_us_32();
+            for (int k = 0; k < 64; k++) {
+                gfx_draw_line_unclipped(buf, lines[4 * k], lines[4 * k + 1], lines[4 * k + 2], lines[4 * k + 3]);
+            }
+            t_ref += t1 - t0;
+            t_run += time_us_32() - t1;
+        }
+        printf("  lines to %2d px: reference %.1f px/us, gfx %.1f px/us\n", reach[r],
+               t_ref ? (float)pixels / t_ref : 0.0f, t_run ? (float)pixels / t_run : 0.0f);
+    }
+    gfx_clear(buf);
+}
+#endif // STARTUP_CHECKS
+
+// Turn by the time since the last frame, so the speed does not depend on
+// the frame rate
+static void advance_angles() {
+    static uint32_t last_us;
+    const uint32_t now = time_us_32();
+    float dt = last_us ? (now - last_us) * 1e-6f : 0.0f;
+    if (dt > 0.1f) dt = 0.1f;
+    last_us = now;
+    frame_dt = dt;
+
+    angle_x += speed * dt;
     if (angle_x > 2 * M_PI) angle_x -= 2 * M_PI;
     
-    angle_y += speed * 1.5f;
+    angle_y += speed * 1.5f * dt;
     if (angle_y > 2 * M_PI) angle_y -= 2 * M_PI;
     
-    angle_z += speed * 0.7f;
+    angle_z += speed * 0.7f * dt;
     if (angle_z > 2 * M_PI) angle_z -= 2 * M_PI;
 }
 
-void draw_ui_elements(unsigned char *buffer) {
+// Close the frame's work time, started right after frame_begin() (which may
+// wait for a free display list or draw buffer)
+static void end_frame_timing(uint32_t t_start) {
+    uint32_t core1_us = time_us_32() - t_start;
+    uint32_t raster_us = last_raster_us;
+    last_frame_us = core1_us > raster_us ? core1_us : raster_us;
+}
+
+// Frames are recorded as display lists and rasterized according to
+// RENDER_MODE (dual_core.h). An animated field's heights are updated as
+// part of the measured frame work.
+static void draw_heightfield_frame(const HeightField *hf, SurfaceAnim *anim, const char *name) {
+    Mat3 rot;
+    mat3_from_euler(&rot, angle_x, angle_y, angle_z);
+
+    GfxLineBatch batch = frame_begin();
+    uint32_t t0 = time_us_32();
+    if (anim) surface_anim_update(anim, frame_dt);
+    emit_heightfield_surface(&batch, hf, &rot, &camera);
+    last_transform_us = time_us_32() - t0;
+    
+    char info_text[32];
+    snprintf(info_text, sizeof(info_text), "%s: %dx%d", name, hf->rows, hf->cols);
+    draw_ui_elements(frame_dl, info_text);
+    frame_end(&batch);
+    end_frame_timing(t0);
+    
+    advance_angles();
+}
+
+static inline int clamp_lod(int lod) {
+    if (lod < 0) return 0;
+    if (lod >= PARABOLOID_LODS) return PARABOLOID_LODS - 1;
+    return lod;
+}
+
+// lod picks the detail level (lod.h)
+void draw_frame(int lod) {
+    draw_heightfield_frame(&paraboloid[clamp_lod(lod)], NULL, "Grid");
+}
+
+// The rippling surface; a new level is bound and refreshed in full
+void draw_ripple_frame(int lod) {
+    lod = clamp_lod(lod);
+    if (lod != ripple_level) {
+        surface_anim_bind(&ripple_anim, &ripple[lod], ripple_z, ripple_lod_modes[lod],
+                          (int16_t)(RIPPLE_PEAK / RIPPLE_Z_SCALE + 0.5f));
+        ripple_level = lod;
+    }
+    draw_heightfield_frame(&ripple[lod], &ripple_anim, "Ripple");
+}
+
+// One frame of an indexed wireframe model with the shared rotation and UI
+void draw_wire_frame(const WireMesh *mesh, geom_t scale) {
+    Mat3 rot;
+    mat3_from_euler(&rot, angle_x, angle_y, angle_z);
+
+    GfxLineBatch batch = frame_begin();
+    uint32_t t0 = time_us_32();
+    int n = wire_mesh_project(mesh, &rot, scale, &camera);
+    last_transform_us = time_us_32() - t0;
+
+#if FILLED_SURFACES
+    wire_mesh_emit_filled(&batch, mesh, n);
+#else
+    wire_mesh_emit(&batch, mesh, n, WIRE_CULL_MODE);
+#endif
+
+    char info_text[32];
+    snprintf(info_text, sizeof(info_text), "Verts: %d", mesh->num_vertices);
+    draw_ui_elements(frame_dl, info_text);
+    frame_end(&batch);
+    end_frame_timing(t0);
+
+    advance_angles();
+}
+
+void draw_ui_elements(DisplayList *dl, const char *info) {
     const char* title = "3D DEMO";
     int title_width = strlen(title) * 6 * 3; 
     int title_x = (SCREEN_WIDTH - title_width) / 2;
     int title_y = 10;
-    gfx_draw_string(buffer, title_x, title_y, title, 3);
+    dl_text(dl, title_x, title_y, title, 3);
     
-    gfx_draw_rect(buffer, title_x - 10, title_y - 5, title_width + 20, 25, false);
+    dl_rect(dl, title_x - 10, title_y - 5, title_width + 20, 25, false);
     
-    gfx_draw_circle(buffer, 20, 20, 8, false);
-    gfx_draw_circle(buffer, 20, 20, 4, true);
+    dl_circle(dl, 20, 20, 8, false);
+    dl_circle(dl, 20, 20, 4, true);
     
-    gfx_draw_circle(buffer, SCREEN_WIDTH - 20, 20, 8, false);
-    gfx_draw_circle(buffer, SCREEN_WIDTH - 20, 20, 4, true);
+    dl_circle(dl, SCREEN_WIDTH - 20, 20, 8, false);
+    dl_circle(dl, SCREEN_WIDTH - 20, 20, 4, true);
     
     char info_text[64];
 
@@ -262,17 +808,18 @@ void draw_ui_elements(unsigned char *buffer) {
     } else {
         snprintf(info_text, sizeof(info_text), "FPS: %.1f", current_fps);
     }
-    gfx_draw_string(buffer, 10, SCREEN_HEIGHT - 20, info_text, 1);
+    dl_text(dl, 10, SCREEN_HEIGHT - 20, info_text, 1);
     
-    snprintf(info_text, sizeof(info_text), "Grid: %dx%d", GRID_SIZE, GRID_SIZE);
-    int info_width = strlen(info_text) * 6; 
-    gfx_draw_string(buffer, SCREEN_WIDTH - info_width - 10, SCREEN_HEIGHT - 20, info_text, 1);
+    int info_width = strlen(info) * 6; 
+    dl_text(dl, SCREEN_WIDTH - info_width - 10, SCREEN_HEIGHT - 20, info, 1);
     
     const char* controls = "Raspberry Pi Pico 3D Graphics Demo";
     int controls_width = strlen(controls) * 6;
     int controls_x = (SCREEN_WIDTH - controls_width) / 2;
-    gfx_draw_string(buffer, controls_x, SCREEN_HEIGHT - 40, controls, 1);
+    dl_text(dl, controls_x, SCREEN_HEIGHT - 40, controls, 1);
 }
 
 void deinit_mesh() {
 }
+
+#endif // DRAW_MESH_H
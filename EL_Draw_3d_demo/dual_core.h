@@ -0,0 +1,254 @@
+// Work split between the two cores
+// 双核分工：core1 负责变换和投影，把一帧记录成显示列表；
+// 显示列表的光栅化和缓冲区交换按 RENDER_MODE 分给两个核
+//
+#ifndef DUAL_CORE_H
+#define DUAL_CORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pico/multicore.h"
+#include "pico/time.h"
+#include "hardware/sync.h"
+#include "el.h"
+#include "simple_gfx.h"
+#include "display_list.h"
+
+// ========== 渲染模式 ==========
+// RENDER_SINGLE_CORE: core1 rasterizes the whole frame, core0 only swaps
+// RENDER_BANDS:       core1 and core0 rasterize the upper and lower half of
+//                     the same frame at once, core1 waits for core0
+// RENDER_PIPELINE:    core1 records frame N+1 while core0 rasterizes and
+//                     presents frame N from the previous display list
+// (cmake -DRENDER_MODE=single|bands|pipeline)
+#define RENDER_SINGLE_CORE 0
+#define RENDER_BANDS       1
+#define RENDER_PIPELINE    2
+
+#ifndef RENDER_MODE
+#define RENDER_MODE RENDER_PIPELINE
+#endif
+
+// Time core0 spent rasterizing the last frame (pipeline mode), for diagnostics
+static volatile uint32_t last_raster_us;
+
+// ========== FIFO 消息 ==========
+// core1 -> core0
+#define CORE_MSG_FRAME_READY 1    // draw buffer is complete, swap it
+#define CORE_MSG_RASTER_BAND 2    // draw the lower band of raster_job
+// core0 -> core1
+#define CORE_MSG_BAND_DONE   3
+#define CORE_MSG_SWAPPED     4    // the frame is shown, the other buffer is free
+
+// ========== 分带光栅化 ==========
+// The EL panel is dual scan: el.c streams rows 0..199 (UD) and 200..399 (LD)
+// separately, so the frame splits along the same line. core1 draws the
+// upper band and core0 the lower one; each core only writes its own rows.
+#define RASTER_SPLIT_Y SCR_REFRESH_LINES
+
+typedef struct {
+    unsigned char *buf;
+    const int16_t *xy;
+    int count;
+    const GfxPoly *polys;
+    int num_polys;
+} RasterJob;
+
+// Written by core1 before CORE_MSG_RASTER_BAND, read by core0 after it
+static RasterJob raster_job;
+
+// core1: draw the polygons and segments of a batch into its buffer, in
+// RENDER_BANDS mode with both cores. Returns once both bands are done
+// (core0's reply is the barrier).
+static inline void raster_batch(const GfxLineBatch *batch) {
+#if RENDER_MODE == RENDER_BANDS
+    raster_job = (RasterJob){ batch->buf, batch->xy, batch->count, batch->polys, batch->poly_count };
+    __dmb();
+    multicore_fifo_push_blocking(CORE_MSG_RASTER_BAND);
+    gfx_fill_polys_band(batch->buf, batch->polys, batch->poly_count, 0, RASTER_SPLIT_Y - 1);
+    gfx_draw_lines_band(batch->buf, batch->xy, batch->count, 0, RASTER_SPLIT_Y - 1);
+    multicore_fifo_pop_blocking();
+    __dmb();
+#else
+    gfx_fill_polys(batch->buf, batch->polys, batch->poly_count);
+    gfx_draw_lines(batch->buf, batch->xy, batch->count);
+#endif
+}
+
+// core0: handle CORE_MSG_RASTER_BAND
+static inline void raster_band_service(void) {
+    __dmb();
+    gfx_fill_polys_band(raster_job.buf, raster_job.polys, raster_job.num_polys,
+                        RASTER_SPLIT_Y, SCR_HEIGHT - 1);
+    gfx_draw_lines_band(raster_job.buf, raster_job.xy, raster_job.count,
+                        RASTER_SPLIT_Y, SCR_HEIGHT - 1);
+    __dmb();
+    multicore_fifo_push_blocking(CORE_MSG_BAND_DONE);
+}
+
+// ========== 单生产者单消费者队列 ==========
+// Lock-free ring of display list indices between exactly one producer core
+// and one consumer core: head is only written by the producer, tail only by
+// the consumer. Waiting is done with WFE, every update sends SEV.
+#define SPSC_SIZE 4       // power of two, >= number of display lists
+
+typedef struct {
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    volatile uint8_t slot[SPSC_SIZE];
+} SpscQueue;
+
+static inline bool spsc_push(SpscQueue *q, uint8_t v) {
+    uint32_t h = q->head;
+    if (h - q->tail == SPSC_SIZE) return false;
+    q->slot[h % SPSC_SIZE] = v;
+    __dmb();              // slot (and the list it names) before head
+    q->head = h + 1;
+    __sev();
+    return true;
+}
+
+static inline bool spsc_pop(SpscQueue *q, uint8_t *v) {
+    uint32_t t = q->tail;
+    if (q->head == t) return false;
+    __dmb();              // head before slot and list contents
+    *v = q->slot[t % SPSC_SIZE];
+    __dmb();
+    q->tail = t + 1;
+    __sev();
+    return true;
+}
+
+static inline uint8_t spsc_pop_blocking(SpscQueue *q) {
+    uint8_t v;
+    while (!spsc_pop(q, &v)) __wfe();
+    return v;
+}
+
+// ========== 显示列表 ==========
+// Pipeline mode double buffers the lists: core1 records one while core0
+// draws the other. dl_ready carries recorded lists to core0, dl_free hands
+// them back. The other modes record and draw on core1 and need only one.
+#if RENDER_MODE == RENDER_PIPELINE
+#define DL_COUNT 2
+#else
+#define DL_COUNT 1
+#endif
+
+static DisplayList display_lists[DL_COUNT];
+#if RENDER_MODE == RENDER_PIPELINE
+static SpscQueue dl_ready;        // core1 -> core0
+static SpscQueue dl_free = { .head = DL_COUNT, .slot = { 0, 1 } };     // core0 -> core1
+#endif
+
+// List core1 is recording into
+static DisplayList *frame_dl;
+// Draw buffer of the frame (single core and bands mode)
+static unsigned char *frame_buf;
+#if RENDER_MODE != RENDER_PIPELINE
+// A frame was handed to core0 and its CORE_MSG_SWAPPED is still due
+static bool frame_swap_pending;
+#endif
+
+#if RENDER_MODE == RENDER_PIPELINE
+static void frame_acquire_list(void) {
+    frame_dl = &display_lists[spsc_pop_blocking(&dl_free)];
+    dl_reset(frame_dl);
+}
+
+static void frame_submit_list(GfxLineBatch *batch, bool end_of_frame) {
+    // Clipping is part of core1's stage, core0 only rasterizes
+    frame_dl->num_lines = gfx_clip_lines(batch->xy, batch->count);
+    frame_dl->num_polys = batch->poly_count;
+    frame_dl->end_of_frame = end_of_frame;
+    spsc_push(&dl_ready, frame_dl - display_lists);
+    batch->count = 0;
+    batch->poly_count = 0;
+}
+
+// Batch full in the middle of a frame: send what there is, go on in the
+// next list
+static void frame_flush_list(GfxLineBatch *batch) {
+    frame_submit_list(batch, false);
+    frame_acquire_list();
+    batch->xy = frame_dl->xy;
+    batch->polys = frame_dl->polys;
+}
+#else
+static void frame_flush_list(GfxLineBatch *batch) {
+    raster_batch(batch);
+}
+#endif
+
+// core1: start recording a frame. Segments and polygons go into the
+// returned batch, overlay commands into frame_dl.
+static inline GfxLineBatch frame_begin(void) {
+#if RENDER_MODE == RENDER_PIPELINE
+    // Blocks while core0 still holds both lists
+    frame_acquire_list();
+#else
+    // Until core0's swap (at the next vsync) the draw buffer is still the
+    // last frame, waiting to be shown
+    if (frame_swap_pending) multicore_fifo_pop_blocking();
+    frame_swap_pending = false;
+    frame_buf = el_get_draw_buffer();
+    gfx_clear(frame_buf);
+    frame_dl = &display_lists[0];
+    dl_reset(frame_dl);
+#endif
+    return (GfxLineBatch){
+        .buf = frame_buf,
+        .xy = frame_dl->xy,
+        .capacity = DL_LINES_MAX,
+        .flush = frame_flush_list,
+        .polys = frame_dl->polys,
+        .poly_capacity = DL_POLYS_MAX,
+    };
+}
+
+// core1: hand the recorded frame over for presenting
+static inline void frame_end(GfxLineBatch *batch) {
+#if RENDER_MODE == RENDER_PIPELINE
+    frame_submit_list(batch, true);
+#else
+    gfx_batch_flush(batch);
+    dl_draw_commands(frame_buf, frame_dl);
+    multicore_fifo_push_blocking(CORE_MSG_FRAME_READY);
+    frame_swap_pending = true;
+#endif
+}
+
+// core0: wait for the next frame, help draw it or draw it (depending on the
+// mode) and present it
+static inline void core0_present_frame(void) {
+#if RENDER_MODE == RENDER_PIPELINE
+    unsigned char *buf = el_get_draw_buffer();
+    uint32_t raster_us = 0;
+    bool end_of_frame = false;
+    for (int n = 0; !end_of_frame; n++) {
+        uint8_t i = spsc_pop_blocking(&dl_ready);
+        const DisplayList *dl = &display_lists[i];
+        uint32_t t0 = time_us_32();
+        // Not before the first list: core1 uses the draw buffer as scratch
+        // for its startup checks
+        if (n == 0) gfx_clear(buf);
+        gfx_fill_polys(buf, dl->polys, dl->num_polys);
+        gfx_draw_lines_unclipped(buf, dl->xy, dl->num_lines);
+        dl_draw_commands(buf, dl);
+        raster_us += time_us_32() - t0;
+        end_of_frame = dl->end_of_frame;
+        spsc_push(&dl_free, i);
+    }
+    last_raster_us = raster_us;
+#else
+    while (multicore_fifo_pop_blocking() == CORE_MSG_RASTER_BAND) {
+        raster_band_service();
+    }
+#endif
+    el_swap_buffer();
+#if RENDER_MODE != RENDER_PIPELINE
+    multicore_fifo_push_blocking(CORE_MSG_SWAPPED);
+#endif
+}
+
+#endif // DUAL_CORE_H
@@ -34,8 +34,9 @@ PIO el_pio = pio0;
 
 int el_udma_chan, el_ldma_chan;
 
-unsigned char framebuf_bp0[SCR_STRIDE * SCR_HEIGHT];
-unsigned char framebuf_bp1[SCR_STRIDE * SCR_HEIGHT];
+// Word aligned: DMA reads and the line rasterizer write them as uint32_t
+unsigned char framebuf_bp0[SCR_STRIDE * SCR_HEIGHT] __attribute__((aligned(4)));
+unsigned char framebuf_bp1[SCR_STRIDE * SCR_HEIGHT] __attribute__((aligned(4)));
 
 static int frame_state = 0;
 volatile int frame_scroll_lines = 0;
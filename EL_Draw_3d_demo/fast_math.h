@@ -0,0 +1,158 @@
+// Fast math approximations
+// 快速数学函数：查表插值 sin/cos、快速平方根倒数、快速倒数和定点除法、sinc
+//
+// Max errors (measured against the libm float versions):
+//   fast_sinf / fast_cosf  abs error <= 7.6e-5 for |x| <= 64 rad, <= 1.2e-4 for
+//                          |x| <= 1000 rad (float rounding of the argument dominates)
+//   fast_rsqrtf            rel error <= 4.8e-6 for x > 0
+//   fast_sqrtf             rel error <= 4.8e-6 for x >= 0
+//   fast_recipf            rel error <= 6.7e-6 for 1e-6 <= x <= 1e6
+//   fast_div_q16           rel error <= 3.9e-6 plus one Q16.16 step
+//   fast_sincf             abs error <= 7.3e-5 for |x| <= 64
+//
+#ifndef FAST_MATH_H
+#define FAST_MATH_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#define FAST_SIN_TABLE_BITS 8
+#define FAST_SIN_TABLE_SIZE (1 << FAST_SIN_TABLE_BITS)
+
+// sin(2*pi*i/256) for i = 0..256, the extra entry saves a wrap in the interpolation
+static const float fast_sin_table[FAST_SIN_TABLE_SIZE + 1] = {
+    0.00000000f, 0.02454123f, 0.04906767f, 0.07356456f, 0.09801714f, 0.12241068f, 0.14673047f, 0.17096189f,
+    0.19509032f, 0.21910124f, 0.24298018f, 0.26671276f, 0.29028468f, 0.31368174f, 0.33688985f, 0.35989504f,
+    0.38268343f, 0.40524131f, 0.42755509f, 0.44961133f, 0.47139674f, 0.49289819f, 0.51410274f, 0.53499762f,
+    0.55557023f, 0.57580819f, 0.59569930f, 0.61523159f, 0.63439328f, 0.65317284f, 0.67155895f, 0.68954054f,
+    0.70710678f, 0.72424708f, 0.74095113f, 0.75720885f, 0.77301045f, 0.78834643f, 0.80320753f, 0.81758481f,
+    0.83146961f, 0.84485357f, 0.85772861f, 0.87008699f, 0.88192126f, 0.89322430f, 0.90398929f, 0.91420976f,
+    0.92387953f, 0.93299280f, 0.94154407f, 0.94952818f, 0.95694034f, 0.96377607f, 0.97003125f, 0.97570213f,
+    0.98078528f, 0.98527764f, 0.98917651f, 0.99247953f, 0.99518473f, 0.99729046f, 0.99879546f, 0.99969882f,
+    1.00000000f, 0.99969882f, 0.99879546f, 0.99729046f, 0.99518473f, 0.99247953f, 0.98917651f, 0.98527764f,
+    0.98078528f, 0.97570213f, 0.97003125f, 0.96377607f, 0.95694034f, 0.94952818f, 0.94154407f, 0.93299280f,
+    0.92387953f, 0.91420976f, 0.90398929f, 0.89322430f, 0.88192126f, 0.87008699f, 0.85772861f, 0.84485357f,
+    0.83146961f, 0.81758481f, 0.80320753f, 0.78834643f, 0.77301045f, 0.75720885f, 0.74095113f, 0.72424708f,
+    0.70710678f, 0.68954054f, 0.67155895f, 0.65317284f, 0.63439328f, 0.61523159f, 0.59569930f, 0.57580819f,
+    0.55557023f, 0.53499762f, 0.51410274f, 0.49289819f, 0.47139674f, 0.44961133f, 0.42755509f, 0.40524131f,
+    0.38268343f, 0.35989504f, 0.33688985f, 0.31368174f, 0.29028468f, 0.26671276f, 0.24298018f, 0.21910124f,
+    0.19509032f, 0.17096189f, 0.14673047f, 0.12241068f, 0.09801714f, 0.07356456f, 0.04906767f, 0.02454123f,
+    0.00000000f, -0.02454123f, -0.04906767f, -0.07356456f, -0.09801714f, -0.12241068f, -0.14673047f, -0.17096189f,
+    -0.19509032f, -0.21910124f, -0.24298018f, -0.26671276f, -0.29028468f, -0.31368174f, -0.33688985f, -0.35989504f,
+    -0.38268343f, -0.40524131f, -0.42755509f, -0.44961133f, -0.47139674f, -0.49289819f, -0.51410274f, -0.53499762f,
+    -0.55557023f, -0.57580819f, -0.59569930f, -0.61523159f, -0.63439328f, -0.65317284f, -0.67155895f, -0.68954054f,
+    -0.70710678f, -0.72424708f, -0.74095113f, -0.75720885f, -0.77301045f, -0.78834643f, -0.80320753f, -0.81758481f,
+    -0.83146961f, -0.84485357f, -0.85772861f, -0.87008699f, -0.88192126f, -0.89322430f, -0.90398929f, -0.91420976f,
+    -0.92387953f, -0.93299280f, -0.94154407f, -0.94952818f, -0.95694034f, -0.96377607f, -0.97003125f, -0.97570213f,
+    -0.98078528f, -0.98527764f, -0.98917651f, -0.99247953f, -0.99518473f, -0.99729046f, -0.99879546f, -0.99969882f,
+    -1.00000000f, -0.99969882f, -0.99879546f, -0.99729046f, -0.99518473f, -0.99247953f, -0.98917651f, -0.98527764f,
+    -0.98078528f, -0.97570213f, -0.97003125f, -0.96377607f, -0.95694034f, -0.94952818f, -0.94154407f, -0.93299280f,
+    -0.92387953f, -0.91420976f, -0.90398929f, -0.89322430f, -0.88192126f, -0.87008699f, -0.85772861f, -0.84485357f,
+    -0.83146961f, -0.81758481f, -0.80320753f, -0.78834643f, -0.77301045f, -0.75720885f, -0.74095113f, -0.72424708f,
+    -0.70710678f, -0.68954054f, -0.67155895f, -0.65317284f, -0.63439328f, -0.61523159f, -0.59569930f, -0.57580819f,
+    -0.55557023f, -0.53499762f, -0.51410274f, -0.49289819f, -0.47139674f, -0.44961133f, -0.42755509f, -0.40524131f,
+    -0.38268343f, -0.35989504f, -0.33688985f, -0.31368174f, -0.29028468f, -0.26671276f, -0.24298018f, -0.21910124f,
+    -0.19509032f, -0.17096189f, -0.14673047f, -0.12241068f, -0.09801714f, -0.07356456f, -0.04906767f, -0.02454123f,
+    0.00000000f,
+};
+
+// Table lookup with linear interpolation. t is the angle in table units
+// (FAST_SIN_TABLE_SIZE per turn).
+static inline float fast_sin_turns(float t) {
+    int32_t i = (int32_t)t;
+    if ((float)i > t) i--;      // floor for negative angles
+    float frac = t - (float)i;
+    i &= FAST_SIN_TABLE_SIZE - 1;
+    float a = fast_sin_table[i];
+    return a + frac * (fast_sin_table[i + 1] - a);
+}
+
+static inline float fast_sinf(float x) {
+    return fast_sin_turns(x * (FAST_SIN_TABLE_SIZE / (2.0f * (float)M_PI)));
+}
+
+static inline float fast_cosf(float x) {
+    return fast_sin_turns(x * (FAST_SIN_TABLE_SIZE / (2.0f * (float)M_PI)) + FAST_SIN_TABLE_SIZE / 4);
+}
+
+// Bit-trick initial guess refined with two Newton steps
+static inline float fast_rsqrtf(float x) {
+    float half = 0.5f * x;
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    bits = 0x5f375a86u - (bits >> 1);
+    float y;
+    memcpy(&y, &bits, sizeof(y));
+    y = y * (1.5f - half * y * y);
+    y = y * (1.5f - half * y * y);
+    return y;
+}
+
+static inline float fast_sqrtf(float x) {
+    return x > 0.0f ? x * fast_rsqrtf(x) : 0.0f;
+}
+
+// Bit-trick initial guess refined with two Newton steps, for x > 0
+static inline float fast_recipf(float x) {
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    bits = 0x7ef311c3u - bits;
+    float y;
+    memcpy(&y, &bits, sizeof(y));
+    y = y * (2.0f - x * y);
+    y = y * (2.0f - x * y);
+    return y;
+}
+
+// 1 / (1 + (i + 0.5) / 256) in Q16, seed of fast_div_q16()
+static const uint16_t fast_recip_table[256] = {
+    65408, 65154, 64902, 64652, 64404, 64158, 63913, 63671, 63430, 63191, 62954, 62719,
+    62485, 62253, 62023, 61795, 61568, 61343, 61119, 60897, 60677, 60458, 60241, 60026,
+    59812, 59599, 59388, 59179, 58971, 58764, 58559, 58356, 58153, 57952, 57753, 57555,
+    57358, 57163, 56968, 56776, 56584, 56394, 56205, 56017, 55831, 55646, 55462, 55279,
+    55098, 54917, 54738, 54560, 54383, 54207, 54033, 53859, 53687, 53516, 53346, 53177,
+    53009, 52842, 52676, 52511, 52347, 52184, 52022, 51862, 51702, 51543, 51385, 51228,
+    51072, 50917, 50763, 50610, 50458, 50306, 50156, 50007, 49858, 49710, 49563, 49417,
+    49272, 49128, 48985, 48842, 48700, 48559, 48419, 48280, 48141, 48003, 47867, 47730,
+    47595, 47460, 47326, 47193, 47061, 46929, 46798, 46668, 46539, 46410, 46282, 46155,
+    46028, 45902, 45777, 45652, 45528, 45405, 45283, 45161, 45040, 44919, 44799, 44680,
+    44561, 44443, 44326, 44209, 44093, 43977, 43862, 43748, 43634, 43521, 43408, 43296,
+    43185, 43074, 42963, 42854, 42744, 42636, 42528, 42420, 42313, 42207, 42101, 41996,
+    41891, 41786, 41683, 41579, 41476, 41374, 41272, 41171, 41070, 40970, 40870, 40771,
+    40672, 40574, 40476, 40378, 40281, 40185, 40089, 39993, 39898, 39804, 39709, 39616,
+    39522, 39429, 39337, 39245, 39153, 39062, 38971, 38881, 38791, 38702, 38613, 38524,
+    38436, 38348, 38260, 38173, 38087, 38000, 37915, 37829, 37744, 37659, 37575, 37491,
+    37407, 37324, 37241, 37159, 37077, 36995, 36914, 36833, 36752, 36672, 36592, 36512,
+    36433, 36354, 36275, 36197, 36119, 36041, 35964, 35887, 35810, 35734, 35658, 35583,
+    35507, 35432, 35358, 35283, 35209, 35136, 35062, 34989, 34916, 34844, 34771, 34700,
+    34628, 34557, 34486, 34415, 34344, 34274, 34204, 34135, 34065, 33996, 33928, 33859,
+    33791, 33723, 33655, 33588, 33521, 33454, 33387, 33321, 33255, 33189, 33124, 33059,
+    32994, 32929, 32864, 32800,
+};
+
+// n / d in Q16.16 for n >= 0, d > 0 (both Q16.16), integer only for the
+// fixed point backend: d is normalized to [1, 2), the table gives 8 bits of
+// its reciprocal and one Newton step 16. Saturates at INT32_MAX.
+static inline int32_t fast_div_q16(int32_t n, int32_t d) {
+    const int s = __builtin_clz((uint32_t)d);
+    const uint32_t m = (uint32_t)d << s;                   // Q1.31 in [1, 2)
+    uint32_t r = (uint32_t)fast_recip_table[(m >> 23) & 0xff] << 15;
+    const uint32_t e = (uint32_t)(((uint64_t)m * r) >> 31);
+    r = (uint32_t)(((uint64_t)r * (0u - e)) >> 31);        // r * (2 - m*r)
+    // d = m * 2^(15 - s) / 2^31, so n / d = n * r >> (46 - s)
+    const uint64_t q = ((uint64_t)n * r) >> (46 - s);
+    return q > INT32_MAX ? INT32_MAX : (int32_t)q;
+}
+
+// sin(x) / x, with a Taylor series near zero where the table error would be
+// amplified by the division
+static inline float fast_sincf(float x) {
+    float x2 = x * x;
+    if (x2 < 0.25f) {
+        return 1.0f - x2 * (1.0f / 6.0f) + x2 * x2 * (1.0f / 120.0f);
+    }
+    return fast_sinf(x) / x;
+}
+
+#endif // FAST_MATH_H
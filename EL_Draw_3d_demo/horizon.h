@@ -0,0 +1,118 @@
+// Floating horizon hidden-line removal
+// 浮动地平线消隐：曲面的网格线按由近到远的顺序送入，每一列记录已画过的
+// 最高点和最低点（屏幕 y 的最小值和最大值）。新线段只有落在这两条
+// “地平线”之外的部分可见，其余部分在进入光栅化之前就被去掉。
+// This assumes that in every column the surface drawn so far covers the
+// whole span between the horizons, which holds when the lines run across
+// the column and each line lies behind the ones before it.
+//
+#ifndef HORIZON_H
+#define HORIZON_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "el.h"
+#include "simple_gfx.h"
+
+// Lines running mostly up and down the screen would cover whole columns, so
+// for those the horizon is kept per screen row instead (transposed: x and y
+// swap roles, HORIZON_SLOTS covers either).
+#define HORIZON_SLOTS SCR_WIDTH
+
+typedef struct {
+    int16_t lo[HORIZON_SLOTS];    // upper horizon: smallest screen y so far
+    int16_t hi[HORIZON_SLOTS];    // lower horizon: largest screen y so far
+    // Extent of the line in progress; it must not hide its own segments,
+    // so it only joins the horizons in horizon_commit()
+    int16_t next_lo[HORIZON_SLOTS];
+    int16_t next_hi[HORIZON_SLOTS];
+    int dirty_min, dirty_max;     // slots touched since the last commit
+    bool transposed;              // per screen row: lo/hi hold x
+} Horizon;
+
+static inline void horizon_reset(Horizon *h, bool transposed) {
+    h->transposed = transposed;
+    for (int x = 0; x < HORIZON_SLOTS; x++) {
+        h->lo[x] = h->next_lo[x] = INT16_MAX;
+        h->hi[x] = h->next_hi[x] = INT16_MIN;
+    }
+    h->dirty_min = HORIZON_SLOTS;
+    h->dirty_max = -1;
+}
+
+// Merge the line just processed into the horizons
+static inline void horizon_commit(Horizon *h) {
+    for (int x = h->dirty_min; x <= h->dirty_max; x++) {
+        if (h->next_lo[x] < h->lo[x]) h->lo[x] = h->next_lo[x];
+        if (h->next_hi[x] > h->hi[x]) h->hi[x] = h->next_hi[x];
+        h->next_lo[x] = INT16_MAX;
+        h->next_hi[x] = INT16_MIN;
+    }
+    h->dirty_min = HORIZON_SLOTS;
+    h->dirty_max = -1;
+}
+
+static inline void horizon_emit(const Horizon *h, GfxLineBatch *batch, int x0, int y0, int x1, int y1) {
+    if (h->transposed) {
+        gfx_batch_add(batch, y0, x0, y1, x1);
+    } else {
+        gfx_batch_add(batch, x0, y0, x1, y1);
+    }
+}
+
+// Test one segment of the current line against the horizons pixel by pixel
+// (along the Bresenham path of its on-screen part) and add the visible runs
+// to the batch. Segments of a line must come after every nearer line has
+// been committed.
+static inline void horizon_segment(Horizon *h, GfxLineBatch *batch, int x0, int y0, int x1, int y1) {
+    if (!gfx_clip_line(&x0, &y0, &x1, &y1)) return;
+    if (h->transposed) {
+        int t = x0; x0 = y0; y0 = t;
+        t = x1; x1 = y1; y1 = t;
+    }
+
+    int lo = x0 < x1 ? x0 : x1, hi = x0 < x1 ? x1 : x0;
+    if (lo < h->dirty_min) h->dirty_min = lo;
+    if (hi > h->dirty_max) h->dirty_max = hi;
+
+    int dx = abs(x1 - x0);
+    int dy = abs(y1 - y0);
+    int sx = (x0 < x1) ? 1 : -1;
+    int sy = (y0 < y1) ? 1 : -1;
+    int err = dx - dy;
+    int x = x0, y = y0;
+    bool in_run = false;
+    int rx0 = 0, ry0 = 0, rx1 = 0, ry1 = 0;
+
+    while (1) {
+        if (y < h->next_lo[x]) h->next_lo[x] = y;
+        if (y > h->next_hi[x]) h->next_hi[x] = y;
+
+        if (y < h->lo[x] || y > h->hi[x]) {
+            if (!in_run) {
+                rx0 = x;
+                ry0 = y;
+                in_run = true;
+            }
+            rx1 = x;
+            ry1 = y;
+        } else if (in_run) {
+            horizon_emit(h, batch, rx0, ry0, rx1, ry1);
+            in_run = false;
+        }
+
+        if (x == x1 && y == y1) break;
+        int e2 = 2 * err;
+        if (e2 > -dy) {
+            err -= dy;
+            x += sx;
+        }
+        if (e2 < dx) {
+            err += dx;
+            y += sy;
+        }
+    }
+    if (in_run) horizon_emit(h, batch, rx0, ry0, rx1, ry1);
+}
+
+#endif // HORIZON_H
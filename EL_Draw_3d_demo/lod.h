@@ -0,0 +1,74 @@
+// Level-of-detail governor
+// 细节层次调节器：用最近 LOD_WINDOW 帧的耗时和帧预算比较，选择下一帧的
+// 细节层次（0 = 最精细）。超出预算时按各层次的相对开销一次降到预计够用的
+// 层次；有足够余量时才升一级，并且每次切换后重新积累一个窗口，避免来回跳动
+//
+#ifndef LOD_H
+#define LOD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Frame budget in microseconds, 60 Hz by default (cmake -DLOD_BUDGET_US=N)
+#ifndef LOD_BUDGET_US
+#define LOD_BUDGET_US 16600
+#endif
+
+// Frames averaged before each decision
+#define LOD_WINDOW 8
+#define LOD_MAX_LEVELS 8
+
+// A finer level is taken only if it is predicted to stay below this share
+// of the budget
+#define LOD_HEADROOM 0.85f
+
+typedef struct {
+    int levels;
+    int level;                        // current level, 0 = full detail
+    uint32_t cost[LOD_MAX_LEVELS];    // relative cost of each level (cells, edges)
+    uint32_t budget_us;
+    uint32_t window[LOD_WINDOW];      // last frame times
+    int samples;                      // frames measured since the last change
+    int next;
+} LodGovernor;
+
+// Start over at full detail, e.g. for another model. cost[] must fall with
+// the level; frame time is taken to be proportional to it.
+static inline void lod_reset(LodGovernor *g, int levels, const uint32_t *cost, uint32_t budget_us) {
+    if (levels > LOD_MAX_LEVELS) levels = LOD_MAX_LEVELS;
+    if (levels < 1) levels = 1;
+    g->levels = levels;
+    g->level = 0;
+    for (int l = 0; l < levels; l++) g->cost[l] = cost ? cost[l] : 1;
+    g->budget_us = budget_us;
+    g->samples = 0;
+    g->next = 0;
+}
+
+// Record the time of the frame just drawn and return the level for the next
+static inline int lod_update(LodGovernor *g, uint32_t frame_us) {
+    g->window[g->next] = frame_us;
+    g->next = (g->next + 1) % LOD_WINDOW;
+    if (++g->samples < LOD_WINDOW) return g->level;
+
+    uint32_t sum = 0;
+    for (int k = 0; k < LOD_WINDOW; k++) sum += g->window[k];
+    const uint64_t avg = sum / LOD_WINDOW;
+    const uint64_t cur = g->cost[g->level] ? g->cost[g->level] : 1;
+
+    int level = g->level;
+    if (avg > g->budget_us) {
+        // Coarser until the predicted time fits
+        while (level + 1 < g->levels && avg * g->cost[level] > (uint64_t)g->budget_us * cur) level++;
+    } else if (level > 0) {
+        const uint64_t limit = (uint64_t)(g->budget_us * LOD_HEADROOM);
+        if (avg * g->cost[level - 1] < limit * cur) level--;
+    }
+    if (level != g->level) {
+        g->level = level;
+        g->samples = 0;
+    }
+    return g->level;
+}
+
+#endif // LOD_H
@@ -11,18 +11,41 @@
 #include "el.h"
 
 #include "draw_mesh.h"
+#include "rot_cup.h"
+#include "models.h"
+#include "dual_core.h"
+#include "lod.h"
 const uint LED_PIN = PICO_DEFAULT_LED_PIN;
 
+// 0 .. MODEL_REGISTRY_COUNT-1 are the registry models (cube, pyramid, heart),
+// followed by the procedural ones
 typedef enum {
-    MODEL_CUBE = 0,
-    MODEL_PYRAMID = 1,
-    MODEL_HEART = 2,
-    MODEL_MESH = 3,
-    MODEL_COUNT = 4
+    MODEL_MESH = MODEL_REGISTRY_COUNT,
+    MODEL_RIPPLE,         // animated height field (surface_anim.h)
+    MODEL_CUP,
+    MODEL_CUPS,           // 20 instances of the cup (scene.h)
+    MODEL_COUNT
 } ModelType;
 
 static ModelType current_model = MODEL_MESH;
 static uint32_t model_switch_counter = 0;
+static LodGovernor lod;
+
+// 切换模型时重新开始调节：高度场按网格单元数，注册表模型按各层次的顶点和
+// 边数，杯子只有一层
+static void lod_start_model(ModelType model) {
+    uint32_t cost[LOD_MAX_LEVELS] = { 1 };
+    int levels = 1;
+    if (model < MODEL_REGISTRY_COUNT) {
+        levels = model_lod_costs(model, cost, LOD_MAX_LEVELS);
+    } else if (model == MODEL_MESH || model == MODEL_RIPPLE) {
+        levels = PARABOLOID_LODS < LOD_MAX_LEVELS ? PARABOLOID_LODS : LOD_MAX_LEVELS;
+        for (int l = 0; l < levels; l++) {
+            cost[l] = (uint32_t)(paraboloid_lod_size[l] - 1) * (paraboloid_lod_size[l] - 1);
+        }
+    }
+    lod_reset(&lod, levels, cost, LOD_BUDGET_US);
+}
 
 void print_memory_info() {
     extern char __StackLimit, __bss_end__;
@@ -44,32 +67,70 @@ uint32_t get_stack_usage() {
 void core1_entry() {
     uint32_t frame_count = 0;
 
+    uint32_t t0 = time_us_32();
     init_mesh();
-
+    init_rot_cup();
+    init_models();
+    printf("Model init: %d us\n", time_us_32() - t0);
+#if STARTUP_CHECKS
+    check_geom_backends();
+    check_line_raster();
+    check_camera();
+    check_surface_anim();
+#endif
+
+    lod_start_model(current_model);
+    absolute_time_t next_frame = get_absolute_time();
     while(1) {
         watchdog_update();
 
         if (frame_count > 0 && frame_count % 2000 == 0) {
             current_model = (current_model + 1) % MODEL_COUNT;
             printf("Switching to model %d\n", current_model);
+            lod_start_model(current_model);
+            if (current_model < MODEL_REGISTRY_COUNT) {
+                model_select(current_model, 0);
+            }
         }
 
         switch (current_model) {
+            default:
+                draw_wire_frame(&model_mesh, GEOM_FROM_FLOAT(MODEL_SCALE));
+                break;
             case MODEL_MESH:
-                draw_frame();
+                draw_frame(lod.level);
+                break;
+            case MODEL_RIPPLE:
+                draw_ripple_frame(lod.level);
                 break;
+            case MODEL_CUP:
+                draw_rot_cup_frame();
+                break;
+            case MODEL_CUPS:
+                draw_cup_scene_frame();
+                break;
+        }
+
+        // 下一帧的细节层次按本帧的实际耗时（不含下面的等待）决定
+        int level = lod.level;
+        if (lod_update(&lod, last_frame_us) != level && current_model < MODEL_REGISTRY_COUNT) {
+            model_select(current_model, lod.level);
         }
 
         if (frame_count % 100 == 0) {
             uint32_t stack_used = get_stack_usage();
-            printf("Core1 frame %d, model %d, stack used: %d bytes\n", 
-                   frame_count, current_model, stack_used);
+            printf("Core1 frame %d, model %d, stack used: %d bytes, transform: %d us, frame: %d us, LOD %d\n",
+                   frame_count, current_model, stack_used, last_transform_us, last_frame_us, lod.level);
         }
         frame_count++;
 
-        multicore_fifo_push_blocking(1);
-
-        sleep_ms(30);
+        // 按帧预算定时出帧；落后时不追赶，从现在重新计时
+        next_frame = delayed_by_us(next_frame, LOD_BUDGET_US);
+        if (absolute_time_diff_us(get_absolute_time(), next_frame) > 0) {
+            sleep_until(next_frame);
+        } else {
+            next_frame = get_absolute_time();
+        }
     }
 }
 
@@ -109,21 +170,19 @@ int main()
 
     uint32_t swap_count = 0;
     while(1) {
-        if (multicore_fifo_rvalid()) {
-            multicore_fifo_pop_blocking();
-            el_swap_buffer();
-            swap_count++;
-
-            if (swap_count % 500 == 0) {
-                printf("Swap count: %d, current model: %d\n", swap_count, current_model);
-                print_memory_info();
-                watchdog_update();
-                gpio_put(LED_PIN, 1);
-                sleep_ms(2);
-                gpio_put(LED_PIN, 0);
-            }
+        // core0 等待 core1 的下一帧，按 RENDER_MODE 参与或负责光栅化，然后交换缓冲区
+        core0_present_frame();
+        swap_count++;
+
+        if (swap_count % 500 == 0) {
+            printf("Swap count: %d, current model: %d, raster: %d us\n",
+                   swap_count, current_model, last_raster_us);
+            print_memory_info();
+            watchdog_update();
+            gpio_put(LED_PIN, 1);
+            sleep_ms(2);
+            gpio_put(LED_PIN, 0);
         }
-        sleep_us(100);
     }
 
     deinit_mesh();
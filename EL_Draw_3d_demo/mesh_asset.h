@@ -0,0 +1,95 @@
+// Binary wireframe mesh assets
+// 二进制线框模型格式：由 tools/mesh_convert.py 在主机上从 OBJ/STL 转换，
+// 直接放在 flash 中使用，绑定时只填指针，不拷贝、不解析
+//
+// Layout (little endian, every offset is in bytes from the start of the
+// blob and 4-byte aligned):
+//
+//   MeshAssetHeader                 magic "WMSH", version, LOD count
+//   MeshAssetLod[num_lods]          LOD 0 is the full mesh, each further
+//                                   level has roughly half the vertices
+//   per LOD: Vertex3Ds[num_vertices]    int16 quantized vertices
+//            MeshEdge[num_edges]        edges deduplicated from faces
+//            uint16_t[strips_len]       polylines, WIRE_STRIP_END separated
+//            uint16_t[num_triangles*3]  faces fanned into triangles, CCW
+//                                       seen from outside
+//            uint16_t[num_edges*2]      triangles on either side of each
+//                                       edge, WIRE_NO_FACE where missing
+//
+#ifndef MESH_ASSET_H
+#define MESH_ASSET_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "transform.h"
+#include "wire_mesh.h"
+
+#define MESH_ASSET_MAGIC   0x48534D57u    // "WMSH"
+#define MESH_ASSET_VERSION 2
+
+typedef struct {
+    float scale[3];
+    float bias[3];
+    uint16_t num_vertices;
+    uint16_t num_edges;
+    uint16_t strips_len;
+    uint16_t num_triangles;
+    uint32_t vertices_offset;
+    uint32_t edges_offset;
+    uint32_t strips_offset;
+    uint32_t triangles_offset;
+    uint32_t edge_faces_offset;
+} MeshAssetLod;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t num_lods;
+    MeshAssetLod lods[];
+} MeshAssetHeader;
+
+// One entry of the flash-resident model registry (model_registry_data.h)
+typedef struct {
+    const char *name;
+    const uint8_t *data;
+    uint32_t size;
+} ModelAsset;
+
+static inline int mesh_asset_num_lods(const ModelAsset *asset) {
+    const MeshAssetHeader *hdr = (const MeshAssetHeader *)asset->data;
+    return hdr->num_lods;
+}
+
+// Point out at LOD level lod of the asset (clamped to the coarsest level).
+// Constant time: the WireMesh references the vertex and index arrays in
+// place. Returns false if the blob is not a mesh asset of this version.
+static inline bool mesh_asset_bind(const ModelAsset *asset, int lod, WireMesh *out) {
+    const MeshAssetHeader *hdr = (const MeshAssetHeader *)asset->data;
+    if (asset->size < sizeof(MeshAssetHeader) || hdr->magic != MESH_ASSET_MAGIC ||
+        hdr->version != MESH_ASSET_VERSION || hdr->num_lods == 0) {
+        return false;
+    }
+    if (lod >= hdr->num_lods) lod = hdr->num_lods - 1;
+    if (lod < 0) lod = 0;
+
+    const MeshAssetLod *l = &hdr->lods[lod];
+    const uint8_t *base = asset->data;
+    *out = (WireMesh){
+        .vertices = (const Vertex3Ds *)(base + l->vertices_offset),
+        .quant = {
+            { l->scale[0], l->scale[1], l->scale[2] },
+            { l->bias[0], l->bias[1], l->bias[2] },
+        },
+        .num_vertices = l->num_vertices,
+        .edges = (const MeshEdge *)(base + l->edges_offset),
+        .num_edges = l->num_edges,
+        .strips = (const uint16_t *)(base + l->strips_offset),
+        .strips_len = l->strips_len,
+        .triangles = (const uint16_t *)(base + l->triangles_offset),
+        .num_triangles = l->num_triangles,
+        .edge_faces = (const uint16_t *)(base + l->edge_faces_offset),
+    };
+    return true;
+}
+
+#endif // MESH_ASSET_H
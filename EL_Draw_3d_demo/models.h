@@ -0,0 +1,51 @@
+// Wireframe models from the flash-resident registry
+// 模型注册表：models/ 下的 OBJ/STL 在编译时转换为二进制资源并嵌入 flash，
+// 切换模型只是把 WireMesh 指向 flash 中的数据，没有分配也没有解析
+//
+#ifndef MODELS_H
+#define MODELS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "wire_mesh.h"
+#include "mesh_asset.h"
+#include "model_registry_data.h"
+
+#define MODEL_SCALE 80
+
+// Mesh of the selected registry entry, pointing into flash
+static WireMesh model_mesh;
+
+// Select registry entry index at LOD level lod (0 = full detail)
+bool model_select(int index, int lod) {
+    if (index < 0 || index >= MODEL_REGISTRY_COUNT) return false;
+    if (!mesh_asset_bind(&model_registry[index], lod, &model_mesh)) {
+        printf("Model %s: bad asset\n", model_registry[index].name);
+        return false;
+    }
+    return true;
+}
+
+// Relative drawing cost (vertices plus edges) of each LOD level of entry
+// index, for the LOD governor. Returns the number of levels.
+int model_lod_costs(int index, uint32_t *cost, int max_levels) {
+    if (index < 0 || index >= MODEL_REGISTRY_COUNT) return 0;
+    int levels = mesh_asset_num_lods(&model_registry[index]);
+    if (levels > max_levels) levels = max_levels;
+    for (int l = 0; l < levels; l++) {
+        WireMesh mesh;
+        if (!mesh_asset_bind(&model_registry[index], l, &mesh)) return l;
+        cost[l] = mesh.num_vertices + mesh.num_edges + mesh.strips_len;
+    }
+    return levels;
+}
+
+void init_models() {
+    for (int i = 0; i < MODEL_REGISTRY_COUNT; i++) {
+        printf("Model %d: %s, %d LODs, %d bytes\n", i, model_registry[i].name,
+               mesh_asset_num_lods(&model_registry[i]), (int)model_registry[i].size);
+    }
+}
+
+#endif // MODELS_H
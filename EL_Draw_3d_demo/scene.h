@@ -0,0 +1,114 @@
+// Scenes of mesh instances
+// 场景：同一个网格画多次，每个实例有自己的位置、缩放和转动相位。
+// 网格数据（顶点、边、条带）只有一份，实例里只放指针和变换；
+// 包围球在加入场景时算好，每帧先按实例位置做视锥测试，看不见的实例
+// 不变换任何顶点
+//
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "transform.h"
+#include "camera.h"
+#include "wire_mesh.h"
+#include "draw_mesh.h"
+
+#define SCENE_MAX_INSTANCES 32
+
+typedef struct {
+    const WireMesh *mesh;     // shared, never copied
+    Vertex3Df pos;            // scene space, pixels
+    float scale;              // pixels per model unit
+    float phase;              // added to the shared spin angles
+    float radius;             // bounding sphere around pos, pixels
+} SceneInstance;
+
+typedef struct {
+    SceneInstance inst[SCENE_MAX_INSTANCES];
+    int count;
+    Vertex3Df origin;         // view-space position of the scene origin
+    int drawn;                // instances drawn in the last frame
+} Scene;
+
+// Add an instance; the mesh's radius is taken from an earlier instance of
+// the same mesh when there is one. Returns false when the scene is full.
+static inline bool scene_add(Scene *scene, const WireMesh *mesh, float x, float y, float z,
+                             float scale, float phase) {
+    if (scene->count == SCENE_MAX_INSTANCES) return false;
+    float r = -1.0f;
+    for (int i = 0; i < scene->count && r < 0.0f; i++) {
+        const SceneInstance *other = &scene->inst[i];
+        if (other->mesh == mesh) r = other->radius / other->scale;
+    }
+    if (r < 0.0f) r = wire_mesh_radius(mesh);
+    scene->inst[scene->count++] = (SceneInstance){ mesh, { x, y, z }, scale, phase, r * scale };
+    return true;
+}
+
+// Emit the instances in view, farthest first so that filled meshes overlap
+// correctly. view turns the scene into view space; each instance also spins
+// by the shared angles plus its phase.
+static inline void scene_emit(GfxLineBatch *batch, Scene *scene, const Mat3 *view,
+                              const Camera *cam, float ax, float ay, float az) {
+    uint8_t order[SCENE_MAX_INSTANCES];
+    Vertex3Df centre[SCENE_MAX_INSTANCES];
+    int visible = 0;
+
+    // Cull on the bounding spheres, insertion sort by depth
+    for (int i = 0; i < scene->count; i++) {
+        const SceneInstance *inst = &scene->inst[i];
+        Vertex3Df c = mat3_apply(view, inst->pos);
+        c.x += scene->origin.x;
+        c.y += scene->origin.y;
+        c.z += scene->origin.z;
+        if (camera_cull_sphere(cam, c.x, c.y, c.z, inst->radius) >= CULL_NEAR) continue;
+        centre[i] = c;
+        int k = visible++;
+        while (k > 0 && centre[order[k - 1]].y < c.y) {
+            order[k] = order[k - 1];
+            k--;
+        }
+        order[k] = i;
+    }
+    scene->drawn = visible;
+
+    for (int k = 0; k < visible; k++) {
+        const SceneInstance *inst = &scene->inst[order[k]];
+        const Vertex3Df *c = &centre[order[k]];
+        Mat3 spin, rot;
+        mat3_from_euler(&spin, ax + inst->phase, ay + inst->phase, az);
+        mat3_mul(&rot, view, &spin);
+        const Vertex3D offset = { GEOM_FROM_FLOAT(c->x), GEOM_FROM_FLOAT(c->y), GEOM_FROM_FLOAT(c->z) };
+        int n = wire_mesh_transform(inst->mesh, &rot, GEOM_FROM_FLOAT(inst->scale), &offset, cam);
+#if FILLED_SURFACES
+        wire_mesh_emit_filled(batch, inst->mesh, n);
+#else
+        wire_mesh_emit(batch, inst->mesh, n, WIRE_CULL_MODE);
+#endif
+    }
+}
+
+// One frame of a scene with the shared camera and UI. The whole scene is
+// tilted by tilt and turns about its vertical axis with angle_z.
+void draw_scene_frame(Scene *scene, float tilt) {
+    Mat3 pitch, yaw, view;
+    mat3_from_euler(&pitch, tilt, 0.0f, 0.0f);
+    mat3_from_euler(&yaw, 0.0f, 0.0f, angle_z);
+    mat3_mul(&view, &pitch, &yaw);
+
+    GfxLineBatch batch = frame_begin();
+    uint32_t t0 = time_us_32();
+    scene_emit(&batch, scene, &view, &camera, angle_x, angle_y, angle_z);
+    last_transform_us = time_us_32() - t0;
+
+    char info_text[32];
+    snprintf(info_text, sizeof(info_text), "Objects: %d of %d", scene->drawn, scene->count);
+    draw_ui_elements(frame_dl, info_text);
+    frame_end(&batch);
+    end_frame_timing(t0);
+
+    advance_angles();
+}
+
+#endif // SCENE_H
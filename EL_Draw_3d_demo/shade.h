@@ -0,0 +1,54 @@
+// Flat shading for the filled renderer
+// 平面着色：按面法线和光照方向的夹角选一级有序抖动灰度（见 simple_gfx.h）
+//
+#ifndef SHADE_H
+#define SHADE_H
+
+#include "transform.h"
+#include "fast_math.h"
+#include "simple_gfx.h"
+
+// Lowest shade of a lit face, so faces turned away from the light still
+// show against the black background
+#define SHADE_AMBIENT 3
+
+// Unit light direction in view space (x right, y away from the viewer, z up):
+// from the upper left, behind the viewer
+static const float shade_light[3] = { -0.4f, -0.6f, 0.69282f };
+
+// Light and view direction in the frame the face normals are given in
+typedef struct {
+    float light[3];
+    float view[3];        // direction the viewer looks along
+} ShadeFrame;
+
+// For normals in view space
+static inline ShadeFrame shade_frame_view(void) {
+    return (ShadeFrame){ { shade_light[0], shade_light[1], shade_light[2] }, { 0.0f, 1.0f, 0.0f } };
+}
+
+// For normals in model space under rotation rot (view = rot * model): the
+// directions are taken back with the transpose, once per frame
+static inline ShadeFrame shade_frame_model(const Mat3 *rot) {
+    ShadeFrame sf;
+    for (int k = 0; k < 3; k++) {
+        sf.light[k] = rot->m[0][k] * shade_light[0] + rot->m[1][k] * shade_light[1] +
+                      rot->m[2][k] * shade_light[2];
+        sf.view[k] = rot->m[1][k];
+    }
+    return sf;
+}
+
+// Shade level (SHADE_AMBIENT .. GFX_SHADES - 1) of a face with normal n of
+// any length. Faces are two-sided: one turned away from the viewer is lit
+// as seen from behind.
+static inline int shade_level(const ShadeFrame *sf, float nx, float ny, float nz) {
+    float len2 = nx * nx + ny * ny + nz * nz;
+    if (len2 <= 0.0f) return SHADE_AMBIENT;
+    float d = nx * sf->light[0] + ny * sf->light[1] + nz * sf->light[2];
+    if (nx * sf->view[0] + ny * sf->view[1] + nz * sf->view[2] > 0.0f) d = -d;
+    if (d <= 0.0f) return SHADE_AMBIENT;
+    return SHADE_AMBIENT + (int)(d * fast_rsqrtf(len2) * (GFX_SHADES - 1 - SHADE_AMBIENT) + 0.5f);
+}
+
+#endif // SHADE_H
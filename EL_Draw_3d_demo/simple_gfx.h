@@ -3,6 +3,8 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
 #include "el.h"
 
 // 简单5x7点阵字体数据
@@ -76,6 +78,26 @@ static const uint8_t font5x7[][5] = {
     ['z' - ' '] = {0x44, 0x64, 0x54, 0x4C, 0x44},
 };
 
+// Projected vertex in screen coordinates
+typedef struct {
+    int16_t x, y;
+} ScreenVertex;
+
+// Cohen-Sutherland outcode of a screen point, 0 when it is on screen
+#define GFX_OUT_LEFT   1
+#define GFX_OUT_RIGHT  2
+#define GFX_OUT_TOP    4
+#define GFX_OUT_BOTTOM 8
+
+static inline uint8_t gfx_outcode(int x, int y) {
+    uint8_t code = 0;
+    if (x < 0) code |= GFX_OUT_LEFT;
+    else if (x >= SCR_WIDTH) code |= GFX_OUT_RIGHT;
+    if (y < 0) code |= GFX_OUT_TOP;
+    else if (y >= SCR_HEIGHT) code |= GFX_OUT_BOTTOM;
+    return code;
+}
+
 // 内联函数实现
 static inline void gfx_set_pixel(unsigned char *buf, int x, int y, bool color) {
     if (x >= 0 && x < SCR_WIDTH && y >= 0 && y < SCR_HEIGHT) {
@@ -94,6 +116,612 @@ static inline bool gfx_get_pixel(unsigned char *buf, int x, int y) {
     return false;
 }
 
+static inline void gfx_clear(unsigned char *buf) {
+    memset(buf, 0, SCR_STRIDE * SCR_HEIGHT);
+}
+
+// ========== 直线裁剪 ==========
+// round(a * b / c) with a 64-bit product, for clip intersections
+static inline int gfx_muldiv_round(int a, int b, int c) {
+    int64_t n = (int64_t)a * b;
+    if ((n < 0) != (c < 0)) return (int)((n - c / 2) / c);
+    return (int)((n + c / 2) / c);
+}
+
+// Cohen-Sutherland: trim the line to the screen given the outcodes of its
+// endpoints. Returns false when nothing of it is visible.
+static inline bool gfx_clip_line_oc(int *x0, int *y0, uint8_t c0, int *x1, int *y1, uint8_t c1) {
+    // Every pass moves one endpoint onto a screen edge; a handful is enough,
+    // the cap only guards against rounding ping-pong
+    for (int pass = 0; c0 | c1; pass++) {
+        if ((c0 & c1) || pass == 8) return false;
+
+        uint8_t out = c0 ? c0 : c1;
+        int dx = *x1 - *x0, dy = *y1 - *y0;
+        int x, y;
+        if (out & GFX_OUT_TOP) {
+            y = 0;
+            x = *x0 + gfx_muldiv_round(dx, y - *y0, dy);
+        } else if (out & GFX_OUT_BOTTOM) {
+            y = SCR_HEIGHT - 1;
+            x = *x0 + gfx_muldiv_round(dx, y - *y0, dy);
+        } else if (out & GFX_OUT_RIGHT) {
+            x = SCR_WIDTH - 1;
+            y = *y0 + gfx_muldiv_round(dy, x - *x0, dx);
+        } else {
+            x = 0;
+            y = *y0 + gfx_muldiv_round(dy, x - *x0, dx);
+        }
+
+        if (out == c0) {
+            *x0 = x;
+            *y0 = y;
+            c0 = gfx_outcode(x, y);
+        } else {
+            *x1 = x;
+            *y1 = y;
+            c1 = gfx_outcode(x, y);
+        }
+    }
+    return true;
+}
+
+static inline bool gfx_clip_line(int *x0, int *y0, int *x1, int *y1) {
+    return gfx_clip_line_oc(x0, y0, gfx_outcode(*x0, *y0), x1, y1, gfx_outcode(*x1, *y1));
+}
+
+// ========== 1bpp 直线光栅化 ==========
+// Pixel x of a row is bit x%8 of byte x/8, so on the little-endian cores a
+// 32-bit word of the row holds pixels 32w .. 32w+31 at bits 0..31 and a
+// horizontal span is at most two masked word ORs plus whole words.
+// Framebuffers must be 4-byte aligned (SCR_STRIDE is a multiple of 4).
+
+// Set pixels xa..xb (xa <= xb) of one row
+static inline void gfx_hspan(uint32_t *row, int xa, int xb) {
+    int wa = xa >> 5, wb = xb >> 5;
+    uint32_t ma = ~0u << (xa & 31);
+    uint32_t mb = ~0u >> (31 - (xb & 31));
+    if (wa == wb) {
+        row[wa] |= ma & mb;
+        return;
+    }
+    row[wa] |= ma;
+    for (int w = wa + 1; w < wb; w++) row[w] = ~0u;
+    row[wb] |= mb;
+}
+
+// 绘制直线（Bresenham算法，按段输出）
+// Produces exactly the pixels of the per-pixel Bresenham loop
+//     err = dx - dy; plot; e2 = 2*err; if (e2 > -dy) x step; if (e2 < dx) y step
+// but emits whole runs along the major axis (run-slice). With n tracking the
+// error, a run is as long as n stays >= 0 while dropping by 2*minor per
+// step. After the first run every run is q or q+1 pixels long
+// (q = major / minor), so only the first one needs a divide; x-major runs
+// are written with gfx_hspan() and y-major runs walk the column by SCR_STRIDE.
+//
+// Lines shorter than GFX_SHORT_LINE pixels along the major axis (most mesh
+// edges) take the per-pixel loop itself: with runs of a pixel or two the
+// divide and the run set-up cost more than they save.
+//
+// Only rows ylo..yhi are written: the line is stepped through rows before
+// the window without drawing and left as soon as it passes the last one, so
+// two cores can draw the same line into disjoint row bands of one buffer.
+// Both endpoints must be on screen and the line must reach the window:
+// there are no bounds checks.
+#ifndef GFX_SHORT_LINE
+#define GFX_SHORT_LINE 16
+#endif
+
+static inline void gfx_draw_line_rows(unsigned char *buf, int x0, int y0, int x1, int y1,
+                                      int ylo, int yhi) {
+    int dx = abs(x1 - x0);
+    int dy = abs(y1 - y0);
+    int sx = (x0 < x1) ? 1 : -1;
+    int sy = (y0 < y1) ? 1 : -1;
+    int err = dx - dy;
+
+    if (dx < GFX_SHORT_LINE && dy < GFX_SHORT_LINE) {
+        unsigned char *row = buf + SCR_STRIDE * y0;
+        const int step = sy * SCR_STRIDE;
+        while (1) {
+            if (y0 >= ylo && y0 <= yhi) row[x0 >> 3] |= 1u << (x0 & 7);
+            if (x0 == x1 && y0 == y1) break;
+            int e2 = 2 * err;
+            if (e2 > -dy) {
+                err -= dy;
+                x0 += sx;
+            }
+            if (e2 < dx) {
+                err += dx;
+                y0 += sy;
+                row += step;
+            }
+        }
+        return;
+    }
+
+    // Rows to pass over before the window and the row the line leaves it at
+    int skip = sy > 0 ? ylo - y0 : y0 - yhi;
+    if (skip < 0) skip = 0;
+    const int y_last = sy > 0 ? yhi : ylo;
+
+    if (dx >= dy) {
+        uint32_t *row = (uint32_t *)(buf + SCR_STRIDE * y0);
+        const int row_step = sy * SCR_STRIDE_WORDS;
+        const int d = 2 * dy;
+        int n = 2 * err - dx;
+        int x = x0, y = y0, left = dx + 1;
+        int len = (n < 0) ? 1 : dy ? n / d + 2 : left;
+        const int q = dy ? dx / dy : 0;
+        const int thr = (q - 1) * d;
+
+        while (1) {
+            if (len > left) len = left;
+            if (skip) {
+                skip--;
+            } else if (sx > 0) {
+                gfx_hspan(row, x, x + len - 1);
+            } else {
+                gfx_hspan(row, x - len + 1, x);
+            }
+
+            left -= len;
+            if (left == 0 || y == y_last) break;
+            x += sx * len;
+            y += sy;
+            n += 2 * dx - len * d;
+            row += row_step;
+            len = q + (n >= thr);
+        }
+    } else {
+        // One pixel per row: the window just trims both ends of the walk
+        int left = dy + 1;
+        if (left > abs(y_last - y0) + 1) left = abs(y_last - y0) + 1;
+
+        int off = SCR_STRIDE * y0 + (x0 >> 3);
+        unsigned int bit = 1u << (x0 & 7);
+        const int step = sy * SCR_STRIDE;
+        const int d = 2 * dx;
+        int m = -dy - 2 * err;
+        int len = (m < 0) ? 1 : dx ? m / d + 2 : left;
+        const int q = dx ? dy / dx : 0;
+        const int thr = (q - 1) * d;
+
+        while (1) {
+            if (len > left) len = left;
+            left -= len;
+            m += 2 * dy - len * d;
+
+            if (skip) {
+                int s = skip < len ? skip : len;
+                skip -= s;
+                len -= s;
+                off += s * step;
+            }
+            for (; len > 0; len--) {
+                buf[off] |= bit;
+                off += step;
+            }
+            if (left == 0) break;
+
+            if (sx > 0) {
+                bit <<= 1;
+                if (bit == 0x100) {
+                    bit = 1;
+                    off++;
+                }
+            } else {
+                bit >>= 1;
+                if (bit == 0) {
+                    bit = 0x80;
+                    off--;
+                }
+            }
+            len = q + (m >= thr);
+        }
+    }
+}
+
+static inline void gfx_draw_line_unclipped(unsigned char *buf, int x0, int y0, int x1, int y1) {
+    gfx_draw_line_rows(buf, x0, y0, x1, y1, 0, SCR_HEIGHT - 1);
+}
+
+// Draw a line whose endpoint outcodes are already known (screen caches)
+static inline void gfx_draw_line_oc(unsigned char *buf, int x0, int y0, uint8_t c0,
+                                    int x1, int y1, uint8_t c1) {
+    if (c0 & c1) return;
+    if ((c0 | c1) && !gfx_clip_line_oc(&x0, &y0, c0, &x1, &y1, c1)) return;
+    gfx_draw_line_unclipped(buf, x0, y0, x1, y1);
+}
+
+static inline void gfx_draw_line(unsigned char *buf, int x0, int y0, int x1, int y1) {
+    gfx_draw_line_oc(buf, x0, y0, gfx_outcode(x0, y0), x1, y1, gfx_outcode(x1, y1));
+}
+
+// ========== 批量画线 ==========
+// Segments are packed as int16 quadruples x0, y0, x1, y1 in screen pixels.
+// One pass classifies, rejects and clips the whole batch. Segments whose
+// endpoints fall on the same pixel are drawn as that pixel: a visible run
+// the floating horizon leaves of a segment can be a single pixel that no
+// other segment covers.
+static inline void gfx_draw_line_packed(unsigned char *buf, const int16_t *seg) {
+    int x0 = seg[0], y0 = seg[1], x1 = seg[2], y1 = seg[3];
+    uint8_t c0 = gfx_outcode(x0, y0), c1 = gfx_outcode(x1, y1);
+    if (c0 & c1) return;
+    if ((c0 | c1) && !gfx_clip_line_oc(&x0, &y0, c0, &x1, &y1, c1)) return;
+    gfx_draw_line_unclipped(buf, x0, y0, x1, y1);
+}
+
+static inline void gfx_draw_lines(unsigned char *buf, const int16_t *xy_pairs, int count) {
+    for (int i = 0; i < count; i++) {
+        gfx_draw_line_packed(buf, xy_pairs + 4 * i);
+    }
+}
+
+// Clip a batch in place: invisible segments are dropped, the rest trimmed
+// to the screen. Returns the new count; the result can be
+// drawn with gfx_draw_lines_unclipped() (e.g. later, on the other core).
+static inline int gfx_clip_lines(int16_t *xy_pairs, int count) {
+    int out = 0;
+    for (int i = 0; i < count; i++) {
+        const int16_t *seg = xy_pairs + 4 * i;
+        int x0 = seg[0], y0 = seg[1], x1 = seg[2], y1 = seg[3];
+        uint8_t c0 = gfx_outcode(x0, y0), c1 = gfx_outcode(x1, y1);
+        if (c0 & c1) continue;
+        if ((c0 | c1) && !gfx_clip_line_oc(&x0, &y0, c0, &x1, &y1, c1)) continue;
+        int16_t *dst = xy_pairs + 4 * out++;
+        dst[0] = x0;
+        dst[1] = y0;
+        dst[2] = x1;
+        dst[3] = y1;
+    }
+    return out;
+}
+
+static inline void gfx_draw_lines_unclipped(unsigned char *buf, const int16_t *xy_pairs, int count) {
+    for (int i = 0; i < count; i++) {
+        const int16_t *seg = xy_pairs + 4 * i;
+        gfx_draw_line_unclipped(buf, seg[0], seg[1], seg[2], seg[3]);
+    }
+}
+
+// Rows ylo..yhi of a batch only. Segments entirely above or below the band
+// are skipped before clipping; the rest are clipped to the whole screen as
+// in gfx_draw_line_packed(), so bands drawn separately (e.g. one per core)
+// add up to exactly the gfx_draw_lines() image without sharing any row.
+static inline void gfx_draw_line_band(unsigned char *buf, int x0, int y0, int x1, int y1,
+                                      int ylo, int yhi) {
+    if ((y0 < ylo && y1 < ylo) || (y0 > yhi && y1 > yhi)) return;
+    uint8_t c0 = gfx_outcode(x0, y0), c1 = gfx_outcode(x1, y1);
+    if (c0 & c1) return;
+    if ((c0 | c1) && !gfx_clip_line_oc(&x0, &y0, c0, &x1, &y1, c1)) return;
+    if ((y0 < ylo && y1 < ylo) || (y0 > yhi && y1 > yhi)) return;
+    gfx_draw_line_rows(buf, x0, y0, x1, y1, ylo, yhi);
+}
+
+static inline void gfx_draw_lines_band(unsigned char *buf, const int16_t *xy_pairs, int count,
+                                       int ylo, int yhi) {
+    for (int i = 0; i < count; i++) {
+        const int16_t *seg = xy_pairs + 4 * i;
+        gfx_draw_line_band(buf, seg[0], seg[1], seg[2], seg[3], ylo, yhi);
+    }
+}
+
+// Rows per bucket when a batch is sorted by starting row
+#define GFX_LINE_SORT_ROWS 8
+#define GFX_LINE_SORT_BUCKETS ((SCR_HEIGHT + GFX_LINE_SORT_ROWS - 1) / GFX_LINE_SORT_ROWS)
+
+// Same as gfx_draw_lines() but in order of the upper endpoint's row, via a
+// counting sort of segment indices into order[count]. The framebuffer is in
+// uncached SRAM on the RP2350, so this only pays off where row order matters
+// (e.g. splitting the work into bands).
+static inline void gfx_draw_lines_sorted(unsigned char *buf, const int16_t *xy_pairs, int count,
+                                         uint16_t *order) {
+    uint16_t start[GFX_LINE_SORT_BUCKETS + 1];
+    memset(start, 0, sizeof(start));
+
+    for (int i = 0; i < count; i++) {
+        const int16_t *seg = xy_pairs + 4 * i;
+        int y = seg[1] < seg[3] ? seg[1] : seg[3];
+        int b = y < 0 ? 0 : y >= SCR_HEIGHT ? GFX_LINE_SORT_BUCKETS - 1 : y / GFX_LINE_SORT_ROWS;
+        start[b + 1]++;
+    }
+    for (int b = 0; b < GFX_LINE_SORT_BUCKETS; b++) start[b + 1] += start[b];
+    for (int i = 0; i < count; i++) {
+        const int16_t *seg = xy_pairs + 4 * i;
+        int y = seg[1] < seg[3] ? seg[1] : seg[3];
+        int b = y < 0 ? 0 : y >= SCR_HEIGHT ? GFX_LINE_SORT_BUCKETS - 1 : y / GFX_LINE_SORT_ROWS;
+        order[start[b]++] = i;
+    }
+    for (int i = 0; i < count; i++) {
+        gfx_draw_line_packed(buf, xy_pairs + 4 * order[i]);
+    }
+}
+
+// ========== 填充多边形 ==========
+// Flat shaded triangles and quads for the filled renderer. A shade is one of
+// GFX_SHADES levels of a 4x4 Bayer ordered dither: level s sets the pixels
+// whose matrix entry is below s. The pattern repeats every 4 pixels, so one
+// row of it is a nibble copied into all 8 nibbles of a framebuffer word and
+// spans are written a word at a time, like gfx_hspan().
+#define GFX_SHADES 17         // 0 = black .. 16 = white
+
+// Edges are stepped in 16.16 fixed point
+#define GFX_FILL_FRAC 16
+#define GFX_FILL_ONE  (1 << GFX_FILL_FRAC)
+
+// 4x4 Bayer matrix; the pattern words of every shade are a table, indexed
+// by shade and row % 4
+#define GFX_BAYER_ROW(s, a, b, c, d) \
+    ((uint32_t)(((a) < (s)) | ((b) < (s)) << 1 | ((c) < (s)) << 2 | ((d) < (s)) << 3) * 0x11111111u)
+#define GFX_DITHER(s) { \
+    GFX_BAYER_ROW(s,  0,  8,  2, 10), \
+    GFX_BAYER_ROW(s, 12,  4, 14,  6), \
+    GFX_BAYER_ROW(s,  3, 11,  1,  9), \
+    GFX_BAYER_ROW(s, 15,  7, 13,  5), \
+}
+
+static const uint32_t gfx_dither[GFX_SHADES][4] = {
+    GFX_DITHER(0),  GFX_DITHER(1),  GFX_DITHER(2),  GFX_DITHER(3),
+    GFX_DITHER(4),  GFX_DITHER(5),  GFX_DITHER(6),  GFX_DITHER(7),
+    GFX_DITHER(8),  GFX_DITHER(9),  GFX_DITHER(10), GFX_DITHER(11),
+    GFX_DITHER(12), GFX_DITHER(13), GFX_DITHER(14), GFX_DITHER(15),
+    GFX_DITHER(16),
+};
+
+// Replace pixels xa..xb (xa <= xb) of one row with the pattern
+static inline void gfx_pattern_span(uint32_t *row, int xa, int xb, uint32_t pattern) {
+    int wa = xa >> 5, wb = xb >> 5;
+    uint32_t ma = ~0u << (xa & 31);
+    uint32_t mb = ~0u >> (31 - (xb & 31));
+    if (wa == wb) {
+        uint32_t m = ma & mb;
+        row[wa] = (row[wa] & ~m) | (pattern & m);
+        return;
+    }
+    row[wa] = (row[wa] & ~ma) | (pattern & ma);
+    for (int w = wa + 1; w < wb; w++) row[w] = pattern;
+    row[wb] = (row[wb] & ~mb) | (pattern & mb);
+}
+
+// A convex polygon of 3 or 4 corners set up for filling, 36 bytes: corners
+// clockwise on screen starting at the top one (so from corner 0 the right
+// side runs forward and the left side backward to the bottom corner) and
+// the x step per row of every edge k -> k+1. Steps are 16.16 and the same
+// whichever way an edge is walked; edges are stepped from their upper end,
+// so two polygons sharing an edge agree on every row and tile without gaps
+// or double pixels.
+// An outlined polygon also has some of its edges drawn as lines right after
+// its fill, so a later polygon covers both; drawn in back to front order
+// with shade 0 this removes hidden lines of a wireframe (painter's
+// algorithm).
+#define GFX_POLY_MAX 4
+
+typedef struct {
+    int16_t x[GFX_POLY_MAX], y[GFX_POLY_MAX];
+    int32_t step[GFX_POLY_MAX];
+    uint8_t n;
+    uint8_t bottom;       // index of the lowest corner
+    uint8_t shade;
+    uint8_t outline;      // bit k: draw edge k -> k+1 over the fill
+} GfxPoly;
+
+// x of an edge at row y, biased by GFX_FILL_ONE - 1 so that the integer
+// part is ceil(x)
+static inline int32_t gfx_edge_x(int xa, int ya, int32_t step, int y) {
+    return xa * GFX_FILL_ONE + step * (y - ya) + (GFX_FILL_ONE - 1);
+}
+
+// Order the corners and compute the steps: all the per-polygon work, done
+// when the polygon is recorded (by core1 in pipeline mode). outline selects
+// edges to draw, bit k for edge xs[k] -> xs[k+1]. Returns false if it draws
+// no pixel on screen or (4 corners) is not convex; an outlined polygon seen
+// edge-on is kept for its edges. Coordinates must stay within +-16383.
+static inline bool gfx_poly_setup(GfxPoly *p, const int *xs, const int *ys, int n, int shade,
+                                  int outline) {
+    // Outlines also cover the pixels on the left and top screen edge
+    const int edge = outline ? -1 : 0;
+    int32_t area = 0;
+    int top = 0;
+    bool left = true, right = true, above = true, below = true;
+    for (int k = 0; k < n; k++) {
+        int k1 = k + 1 < n ? k + 1 : 0;
+        area += xs[k] * ys[k1] - xs[k1] * ys[k];
+        if (ys[k] < ys[top]) top = k;
+        left &= xs[k] <= edge;
+        right &= xs[k] >= SCR_WIDTH;
+        above &= ys[k] <= edge;
+        below &= ys[k] >= SCR_HEIGHT;
+    }
+    if ((area == 0 && !outline) || left || right || above || below) return false;
+    const int dir = area >= 0 ? 1 : -1;    // > 0: clockwise (y points down)
+    if (n == 4) {
+        // Every turn the same way as the whole outline
+        for (int k = 0; k < 4; k++) {
+            int k1 = (k + 1) & 3, k2 = (k + 2) & 3;
+            int32_t turn = (xs[k1] - xs[k]) * (ys[k2] - ys[k1]) - (ys[k1] - ys[k]) * (xs[k2] - xs[k1]);
+            if (turn * dir < 0) return false;
+        }
+    }
+
+    int src = top, bottom = 0;
+    p->outline = 0;
+    for (int k = 0; k < n; k++) {
+        p->x[k] = xs[src];
+        p->y[k] = ys[src];
+        if (p->y[k] > p->y[bottom]) bottom = k;
+        // Walked backwards, edge k is the source edge ending at src
+        if (outline & (1 << (dir > 0 ? src : (src + n - 1) % n))) p->outline |= 1 << k;
+        src += dir;
+        if (src == n) src = 0;
+        if (src < 0) src = n - 1;
+    }
+    for (int k = 0; k < n; k++) {
+        int k1 = k + 1 < n ? k + 1 : 0;
+        int dy = p->y[k1] - p->y[k];
+        p->step[k] = dy ? (int32_t)((p->x[k1] - p->x[k]) * GFX_FILL_ONE) / dy : 0;
+    }
+    p->n = n;
+    p->bottom = bottom;
+    p->shade = shade < 0 ? 0 : shade >= GFX_SHADES ? GFX_SHADES - 1 : shade;
+    return true;
+}
+
+// Rows y..y_end-1 between a left and a right edge: pixels ceil(l) .. ceil(r) - 1
+static inline void gfx_fill_rows(unsigned char *buf, int y, int y_end, int32_t l, int32_t dl,
+                                 int32_t r, int32_t dr, const uint32_t *pattern) {
+    uint32_t *row = (uint32_t *)buf + y * SCR_STRIDE_WORDS;
+    for (; y < y_end; y++) {
+        int x0 = l >> GFX_FILL_FRAC;
+        int x1 = (r >> GFX_FILL_FRAC) - 1;
+        if (x0 < 0) x0 = 0;
+        if (x1 > SCR_WIDTH - 1) x1 = SCR_WIDTH - 1;
+        if (x0 <= x1) gfx_pattern_span(row, x0, x1, pattern[y & 3]);
+        l += dl;
+        r += dr;
+        row += SCR_STRIDE_WORDS;
+    }
+}
+
+// Scanline fill of rows ylo..yhi of a polygon. Pixel (x, y) is covered when
+// it lies in the half-open span [left, right) of row y, and rows run from the
+// top corner up to but excluding the bottom one, so adjacent polygons share
+// no pixels. Rows are filled in runs between the corners, where the left
+// and the right edge change; inside a run the loop only tests the screen
+// sides.
+static inline void gfx_fill_poly_rows(unsigned char *buf, const GfxPoly *p, int ylo, int yhi) {
+    const uint32_t *pattern = gfx_dither[p->shade];
+    const int n = p->n;
+    int l0 = 0, l1 = n - 1;       // left edge: upper and lower corner
+    int r0 = 0, r1 = 1;           // right edge
+    int y = p->y[0];
+
+    while (y <= yhi) {
+        // Move on past finished (and horizontal) edges
+        while (p->y[l1] <= y) {
+            if (l1 == p->bottom) return;
+            l0 = l1;
+            l1 = l1 ? l1 - 1 : n - 1;
+        }
+        while (p->y[r1] <= y) {
+            if (r1 == p->bottom) return;
+            r0 = r1;
+            r1 = r1 + 1 < n ? r1 + 1 : 0;
+        }
+
+        int y_end = p->y[l1] < p->y[r1] ? p->y[l1] : p->y[r1];
+        int y0 = y > ylo ? y : ylo;
+        int y1 = y_end < yhi + 1 ? y_end : yhi + 1;
+        if (y0 < y1) {
+            // The left edge runs l1 -> l0 in corner order
+            int32_t sl = p->step[l1], sr = p->step[r0];
+            gfx_fill_rows(buf, y0, y1,
+                          gfx_edge_x(p->x[l0], p->y[l0], sl, y0), sl,
+                          gfx_edge_x(p->x[r0], p->y[r0], sr, y0), sr, pattern);
+        }
+        y = y_end;
+    }
+}
+
+// Outlined edges of a polygon in rows ylo..yhi, clipped to the screen here
+// since polygons are recorded unclipped
+static inline void gfx_outline_poly_rows(unsigned char *buf, const GfxPoly *p, int ylo, int yhi) {
+    for (int k = 0; k < p->n; k++) {
+        if (!(p->outline & (1 << k))) continue;
+        int k1 = k + 1 < p->n ? k + 1 : 0;
+        gfx_draw_line_band(buf, p->x[k], p->y[k], p->x[k1], p->y[k1], ylo, yhi);
+    }
+}
+
+static inline void gfx_fill_polys_band(unsigned char *buf, const GfxPoly *polys, int count,
+                                       int ylo, int yhi) {
+    for (int i = 0; i < count; i++) {
+        gfx_fill_poly_rows(buf, &polys[i], ylo, yhi);
+        if (polys[i].outline) gfx_outline_poly_rows(buf, &polys[i], ylo, yhi);
+    }
+}
+
+// Polygons are drawn in order, later ones (and their outlines) over earlier ones
+static inline void gfx_fill_polys(unsigned char *buf, const GfxPoly *polys, int count) {
+    gfx_fill_polys_band(buf, polys, count, 0, SCR_HEIGHT - 1);
+}
+
+// Segment batch collected by a renderer and drawn with one gfx_draw_lines()
+// call. If it fills up before the frame is done it is drawn and reused.
+// With a flush function set, that is called instead of drawing into buf
+// (it may also point xy and polys at fresh storage).
+// Filled polygons (poly_capacity > 0) are collected alongside; when drawn,
+// the polygons of a batch go first and its segments over them.
+typedef struct GfxLineBatch {
+    unsigned char *buf;
+    int16_t *xy;          // 4 * capacity
+    uint16_t *order;      // capacity entries to draw sorted by row, or NULL
+    int count;
+    int capacity;
+    void (*flush)(struct GfxLineBatch *batch);
+    GfxPoly *polys;       // poly_capacity
+    int poly_count;
+    int poly_capacity;
+} GfxLineBatch;
+
+static inline void gfx_batch_flush(GfxLineBatch *batch) {
+    if (batch->flush) {
+        batch->flush(batch);
+    } else {
+        gfx_fill_polys(batch->buf, batch->polys, batch->poly_count);
+        if (batch->order) {
+            gfx_draw_lines_sorted(batch->buf, batch->xy, batch->count, batch->order);
+        } else {
+            gfx_draw_lines(batch->buf, batch->xy, batch->count);
+        }
+    }
+    batch->count = 0;
+    batch->poly_count = 0;
+}
+
+static inline void gfx_batch_add(GfxLineBatch *batch, int x0, int y0, int x1, int y1) {
+    if (batch->count == batch->capacity) gfx_batch_flush(batch);
+    int16_t *seg = batch->xy + 4 * batch->count++;
+    seg[0] = x0;
+    seg[1] = y0;
+    seg[2] = x1;
+    seg[3] = y1;
+}
+
+static inline void gfx_batch_add_poly(GfxLineBatch *batch, const int *xs, const int *ys, int n,
+                                      int shade, int outline) {
+    if (batch->poly_count == batch->poly_capacity) gfx_batch_flush(batch);
+    if (gfx_poly_setup(&batch->polys[batch->poly_count], xs, ys, n, shade, outline)) batch->poly_count++;
+}
+
+static inline void gfx_batch_add_tri(GfxLineBatch *batch, int x0, int y0, int x1, int y1,
+                                     int x2, int y2, int shade) {
+    const int xs[3] = { x0, x1, x2 }, ys[3] = { y0, y1, y2 };
+    gfx_batch_add_poly(batch, xs, ys, 3, shade, 0);
+}
+
+// One shade over corners 0..3 in order, with the edges in outline (bit k:
+// corner k -> k+1) drawn over it; split along 0-2 if not convex, the
+// diagonal is never outlined
+static inline void gfx_batch_add_quad_outlined(GfxLineBatch *batch, int x0, int y0, int x1, int y1,
+                                               int x2, int y2, int x3, int y3, int shade, int outline) {
+    const int xs[4] = { x0, x1, x2, x3 }, ys[4] = { y0, y1, y2, y3 };
+    if (batch->poly_count == batch->poly_capacity) gfx_batch_flush(batch);
+    if (gfx_poly_setup(&batch->polys[batch->poly_count], xs, ys, 4, shade, outline)) {
+        batch->poly_count++;
+        return;
+    }
+    const int xa[3] = { x0, x1, x2 }, ya[3] = { y0, y1, y2 };
+    const int xb[3] = { x0, x2, x3 }, yb[3] = { y0, y2, y3 };
+    gfx_batch_add_poly(batch, xa, ya, 3, shade, outline & 3);
+    gfx_batch_add_poly(batch, xb, yb, 3, shade, (outline >> 1) & 6);
+}
+
+static inline void gfx_batch_add_quad(GfxLineBatch *batch, int x0, int y0, int x1, int y1,
+                                      int x2, int y2, int x3, int y3, int shade) {
+    gfx_batch_add_quad_outlined(batch, x0, y0, x1, y1, x2, y2, x3, y3, shade, 0);
+}
+
 // 绘制单个字符
 static inline void gfx_draw_char(unsigned char *buf, int x, int y, char c, int size) {
     if (c < ' ' || c > 'z') return; // 超出字体范围
@@ -0,0 +1,155 @@
+// Animated height fields
+// 动画高度场：网格的 x/y 和拓扑不变，每帧只改写 z。高度是两项之和，
+// 两项都拆成可分离的因子，所以每个顶点每帧只要 4 次整数乘加：
+//   涟漪   env(r) * cos(r - w t) = P * cos(w t) + Q * sin(w t)
+//          P、Q 是构建时生成的常量表（tools/gen_mesh_tables.py）
+//   行进波 a * sin(kx x + ky y - w t) = sin(kx x) * a cos(ky y - w t) + cos(kx x) * a sin(ky y - w t)
+//          行因子绑定时算一次，列因子每帧算一次（每列一次 sin/cos）
+//
+#ifndef SURFACE_ANIM_H
+#define SURFACE_ANIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include "fast_math.h"
+#include "transform.h"
+
+// Largest grid side the row and column factors are kept for
+#define SURFACE_ANIM_MAX_SIDE 256
+
+// Grid points updated per frame at most. A bigger grid is refreshed a band
+// of rows at a time, round robin, so the cost stays bounded and the surface
+// lags instead (cmake -DSURFACE_ANIM_BUDGET=N).
+#ifndef SURFACE_ANIM_BUDGET
+#define SURFACE_ANIM_BUDGET (64 * 64)
+#endif
+
+typedef struct {
+    HeightField *hf;          // z points at the buffer below while bound
+    int16_t *z;               // rows * cols heights, SRAM
+    const int16_t *modes;     // P, Q per grid point, NULL for no ripple
+    float ripple_w;           // rad/s
+    float ripple_phase;
+    int16_t wave_amp;         // in raw heights, 0 for no wave
+    float wave_kx, wave_ky;   // rad per world unit along x and y
+    float wave_w;             // rad/s
+    float wave_phase;
+    int16_t row_s[SURFACE_ANIM_MAX_SIDE], row_c[SURFACE_ANIM_MAX_SIDE];      // Q15
+    int16_t col_c[SURFACE_ANIM_MAX_SIDE], col_s[SURFACE_ANIM_MAX_SIDE];      // raw heights
+    float kx_step, ky_step;   // the same per grid step of the bound field
+    int next_row;             // where the next partial update starts
+    bool refresh;             // update every row on the next frame
+} SurfaceAnim;
+
+// Bound on the height step between neighbouring points in direction
+// (di, dj) at any time: the ripple term changes by dP cos + dQ sin, at most
+// |dP, dQ| (scanned from the modes), the wave by at most
+// 2 wave_amp sin(k_step / 2) for phase step k_step; +6 for the rounding of
+// both terms at either point. Never more than the z range,
+// 2 (ripple_peak + wave_amp).
+static inline int surface_anim_max_step(const SurfaceAnim *a, const HeightField *hf, int di, int dj,
+                                        float k_step, int16_t ripple_peak) {
+    float ripple = 0;
+    if (a->modes) {
+        for (int i = 0; i + di < hf->rows; i++) {
+            const int16_t *pq0 = a->modes + 2 * i * hf->cols;
+            const int16_t *pq1 = pq0 + 2 * (di * hf->cols + dj);
+            for (int j = 0; j + dj < hf->cols; j++) {
+                const float dp = pq1[2 * j] - pq0[2 * j], dq = pq1[2 * j + 1] - pq0[2 * j + 1];
+                const float d = dp * dp + dq * dq;
+                if (d > ripple) ripple = d;
+            }
+        }
+        ripple = sqrtf(ripple);
+    }
+    const float wave = 2.0f * a->wave_amp * fabsf(fast_sinf(0.5f * k_step));
+    const int step = (int)(ripple + wave) + 6;
+    const int envelope = 2 * (ripple_peak + a->wave_amp);
+    return step < envelope ? step : envelope;
+}
+
+// Animate hf with the ripple modes (P, Q pairs for its grid) and the wave
+// set up in a. The heights have to leave room for both:
+// ripple_peak (the largest |P, Q|) + wave_amp <= 32767.
+// The z range and the neighbour steps are set to bounds over the whole
+// animation once, so culling and the hidden-line order stay conservative
+// without rescanning the heights every frame.
+static inline void surface_anim_bind(SurfaceAnim *a, HeightField *hf, int16_t *z,
+                                     const int16_t *modes, int16_t ripple_peak) {
+    a->hf = hf;
+    a->z = z;
+    a->modes = modes;
+    hf->z = z;
+    hf->z_min = -(ripple_peak + a->wave_amp);
+    hf->z_max = ripple_peak + a->wave_amp;
+    a->kx_step = a->wave_kx * GEOM_TO_FLOAT(hf->dx);
+    a->ky_step = a->wave_ky * GEOM_TO_FLOAT(hf->dy);
+    hf->dz_i = surface_anim_max_step(a, hf, 1, 0, a->kx_step, ripple_peak);
+    hf->dz_j = surface_anim_max_step(a, hf, 0, 1, a->ky_step, ripple_peak);
+    for (int i = 0; i < hf->rows && i < SURFACE_ANIM_MAX_SIDE; i++) {
+        a->row_s[i] = (int16_t)(32767.0f * fast_sinf(a->kx_step * i));
+        a->row_c[i] = (int16_t)(32767.0f * fast_cosf(a->kx_step * i));
+    }
+    a->next_row = 0;
+    a->refresh = true;
+}
+
+static inline float surface_anim_wrap(float phase) {
+    if (phase > 2 * M_PI) phase -= 2 * M_PI;
+    return phase;
+}
+
+// Heights of rows first .. first+count-1
+static inline void surface_anim_rows(SurfaceAnim *a, int first, int count) {
+    const int cols = a->hf->cols;
+    const int32_t c = (int32_t)(32767.0f * fast_cosf(a->ripple_phase));
+    const int32_t s = (int32_t)(32767.0f * fast_sinf(a->ripple_phase));
+    const int16_t *col_c = a->col_c, *col_s = a->col_s;
+
+    for (int i = first; i < first + count; i++) {
+        int16_t *z = a->z + i * cols;
+        const int32_t rs = a->row_s[i], rc = a->row_c[i];
+        if (a->modes) {
+            const int16_t *pq = a->modes + 2 * i * cols;
+            for (int j = 0; j < cols; j++) {
+                z[j] = (int16_t)((pq[2 * j] * c + pq[2 * j + 1] * s + rs * col_c[j] + rc * col_s[j]) >> 15);
+            }
+        } else {
+            for (int j = 0; j < cols; j++) {
+                z[j] = (int16_t)((rs * col_c[j] + rc * col_s[j]) >> 15);
+            }
+        }
+    }
+}
+
+// Advance the animation by dt seconds and rewrite the heights, within
+// SURFACE_ANIM_BUDGET grid points unless a full refresh is due
+static inline void surface_anim_update(SurfaceAnim *a, float dt) {
+    const HeightField *hf = a->hf;
+    a->ripple_phase = surface_anim_wrap(a->ripple_phase + a->ripple_w * dt);
+    a->wave_phase = surface_anim_wrap(a->wave_phase + a->wave_w * dt);
+
+    // Column factors of the wave, once per frame
+    for (int j = 0; j < hf->cols && j < SURFACE_ANIM_MAX_SIDE; j++) {
+        const float p = a->ky_step * j - a->wave_phase;
+        a->col_c[j] = (int16_t)(a->wave_amp * fast_cosf(p));
+        a->col_s[j] = (int16_t)(a->wave_amp * fast_sinf(p));
+    }
+
+    int rows = SURFACE_ANIM_BUDGET / hf->cols;
+    if (rows < 1) rows = 1;
+    if (a->refresh || rows >= hf->rows) {
+        surface_anim_rows(a, 0, hf->rows);
+        a->refresh = false;
+        return;
+    }
+    while (rows > 0) {
+        int count = hf->rows - a->next_row < rows ? hf->rows - a->next_row : rows;
+        surface_anim_rows(a, a->next_row, count);
+        rows -= count;
+        a->next_row = (a->next_row + count) % hf->rows;
+    }
+}
+
+#endif // SURFACE_ANIM_H
@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+"""Embed .wmsh mesh assets into model_registry_data.h.
+
+Each asset becomes a 4-byte aligned const byte array (linked into flash)
+and one entry of model_registry[], named after the file stem, in the order
+given on the command line.
+
+usage: embed_models.py cube.wmsh heart.wmsh ... -o model_registry_data.h
+"""
+
+import argparse
+import os
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("assets", nargs="+")
+    ap.add_argument("-o", "--output", required=True)
+    args = ap.parse_args()
+
+    out = []
+    out.append("// Generated by tools/embed_models.py, do not edit")
+    out.append("#ifndef MODEL_REGISTRY_DATA_H")
+    out.append("#define MODEL_REGISTRY_DATA_H")
+    out.append("")
+    out.append("#include <stdint.h>")
+    out.append('#include "mesh_asset.h"')
+    out.append("")
+
+    names = []
+    for path in args.assets:
+        name = os.path.splitext(os.path.basename(path))[0]
+        with open(path, "rb") as f:
+            data = f.read()
+        names.append((name, len(data)))
+        out.append("static const uint8_t model_data_%s[%d] __attribute__((aligned(4))) = {"
+                   % (name, len(data)))
+        for k in range(0, len(data), 16):
+            out.append("    " + ", ".join("0x%02x" % b for b in data[k:k + 16]) + ",")
+        out.append("};")
+        out.append("")
+
+    out.append("#define MODEL_REGISTRY_COUNT %d" % len(names))
+    out.append("")
+    out.append("static const ModelAsset model_registry[MODEL_REGISTRY_COUNT] = {")
+    for name, size in names:
+        out.append('    { "%s", model_data_%s, %d },' % (name, name, size))
+    out.append("};")
+    out.append("")
+    out.append("#endif // MODEL_REGISTRY_DATA_H")
+
+    with open(args.output, "w") as f:
+        f.write("\n".join(out) + "\n")
+
+
+if __name__ == "__main__":
+    main()
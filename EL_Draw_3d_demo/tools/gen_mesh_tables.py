@@ -0,0 +1,244 @@
+#!/usr/bin/env python3
+"""Generate mesh_tables.h: static model data as const tables.
+
+The paraboloid height field and the cup wireframe never change at run time,
+so they are computed here at build time instead of in init_mesh() /
+init_rot_cup(). Being const they are linked into flash and read through XIP;
+no SRAM and no boot time is spent on them.
+
+The height field also gets coarser detail levels for the LOD governor
+(lod.h): level l samples the same surface on a grid of about
+grid_size / sqrt(2)^l points per side, so each level halves the cell count.
+
+The animated ripple surface (surface_anim.h) is stored as two modes per
+grid point, P = env(r) * cos(r) and Q = env(r) * sin(r), so that at run time
+env(r) * cos(r - w*t) = P * cos(w*t) + Q * sin(w*t) costs two multiplies.
+
+usage: gen_mesh_tables.py [--grid-size N] [--lods N] -o mesh_tables.h
+"""
+
+import argparse
+import math
+
+# Paraboloid grid, must cover the range the heights are quantized to
+RANGE = 10.0
+Z_MIN = -1.5
+Z_MAX = 5.0
+
+# Ripple surface: peak of the ripple and of the travelling wave added at
+# run time, both in world units; the heights share one int16 range
+RIPPLE_PEAK = 4.0
+RIPPLE_WAVE_PEAK = 1.0
+RIPPLE_Z_SCALE = (RIPPLE_PEAK + RIPPLE_WAVE_PEAK) / 32767.0
+
+# Cup
+CUP_RADIUS = 1.5
+CUP_HEIGHT = 3.0
+HANDLE_RADIUS = 0.5
+SEGMENTS = 16
+CUP_EXTENT_XY = CUP_RADIUS + 2 * HANDLE_RADIUS
+CUP_EXTENT_Z = CUP_HEIGHT / 2
+
+STRIP_END = 0xFFFF
+
+
+def quantize(f, scale, bias):
+    # Same rounding as QUANT_FROM_FLOAT in transform.h
+    v = (f - bias) / scale
+    q = int(v - 0.5) if v < 0 else int(v + 0.5)
+    return max(-32767, min(32767, q))
+
+
+def calculate_zx(u, v):
+    r = math.sqrt(u * u + v * v)
+    if r == 0.0:
+        return 1.0
+    return 5 * math.sin(r) / r
+
+
+def paraboloid_heights(grid_size):
+    step = (2.0 * RANGE) / (grid_size - 1)
+    bias = (Z_MAX + Z_MIN) / 2
+    scale = (Z_MAX - Z_MIN) / 65534.0
+    heights = []
+    for i in range(grid_size):
+        for j in range(grid_size):
+            x = -RANGE + step * i
+            y = -RANGE + step * j
+            heights.append(quantize(calculate_zx(x, y), scale, bias))
+    return heights
+
+
+def ripple_envelope(r):
+    # About RIPPLE_PEAK / r away from the centre, like the sinc, but finite
+    return RIPPLE_PEAK / math.sqrt(1.0 + r * r)
+
+
+def ripple_modes(grid_size):
+    step = (2.0 * RANGE) / (grid_size - 1)
+    modes = []
+    for i in range(grid_size):
+        for j in range(grid_size):
+            x = -RANGE + step * i
+            y = -RANGE + step * j
+            r = math.sqrt(x * x + y * y)
+            env = ripple_envelope(r)
+            modes.append(quantize(env * math.cos(r), RIPPLE_Z_SCALE, 0.0))
+            modes.append(quantize(env * math.sin(r), RIPPLE_Z_SCALE, 0.0))
+    return modes
+
+
+def lod_grid_sizes(grid_size, lods):
+    sizes = []
+    for level in range(lods):
+        n = max(2, int(round(grid_size / math.sqrt(2) ** level)))
+        if sizes and n >= sizes[-1]:
+            break
+        sizes.append(n)
+    return sizes
+
+
+def cup():
+    sxy = CUP_EXTENT_XY / 32767.0
+    sz = CUP_EXTENT_Z / 32767.0
+
+    def q(x, y, z):
+        return (quantize(x, sxy, 0.0), quantize(y, sxy, 0.0), quantize(z, sz, 0.0))
+
+    top, bottom, handle_top, handle_bottom = [], [], [], []
+    for i in range(SEGMENTS):
+        a = 2.0 * math.pi * i / SEGMENTS
+        x = CUP_RADIUS * math.cos(a)
+        y = CUP_RADIUS * math.sin(a)
+        top.append(q(x, y, CUP_HEIGHT / 2))
+        bottom.append(q(x, y, -CUP_HEIGHT / 2))
+
+        # Handle, offset towards +x/+y
+        hx = CUP_RADIUS + HANDLE_RADIUS * (1 - math.cos(a))
+        hy = CUP_RADIUS + HANDLE_RADIUS * math.sin(a)
+        hz = (CUP_HEIGHT / 4) * math.sin(a)
+        handle_top.append(q(hx, hy, hz))
+        handle_bottom.append(q(hx, hy, -hz))
+    vertices = top + bottom + handle_top + handle_bottom
+
+    # Verticals joining the rims are loose edges; each rim and each half of
+    # the handle is one closed strip
+    edges = [(i, i + SEGMENTS) for i in range(SEGMENTS)]
+    strips = []
+    for first in (0, SEGMENTS, 2 * SEGMENTS, 3 * SEGMENTS):
+        strips += [first + (i % SEGMENTS) for i in range(SEGMENTS + 1)]
+        strips.append(STRIP_END)
+
+    # The side wall as two triangles per segment, CCW seen from outside, so
+    # the verticals on the far side can be culled. Vertical i lies between
+    # segment i - 1 (first triangle) and segment i (second triangle).
+    triangles, edge_faces = [], []
+    for i in range(SEGMENTS):
+        j = (i + 1) % SEGMENTS
+        triangles.append((SEGMENTS + i, SEGMENTS + j, j))
+        triangles.append((SEGMENTS + i, j, i))
+    for i in range(SEGMENTS):
+        edge_faces.append((2 * ((i - 1) % SEGMENTS), 2 * i + 1))
+    return vertices, edges, strips, triangles, edge_faces
+
+
+def c_float(f):
+    s = "%.1ff" % f
+    return "(%s)" % s if f < 0 else s
+
+
+def format_list(items, per_line, indent="    "):
+    lines = []
+    for k in range(0, len(items), per_line):
+        lines.append(indent + ", ".join(items[k:k + per_line]) + ",")
+    return "\n".join(lines)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--grid-size", type=int, default=64)
+    ap.add_argument("--lods", type=int, default=5, help="height field detail levels")
+    ap.add_argument("-o", "--output", required=True)
+    args = ap.parse_args()
+
+    n = args.grid_size
+    sizes = lod_grid_sizes(n, max(1, args.lods))
+    cup_vertices, cup_edges, cup_strips, cup_triangles, cup_edge_faces = cup()
+
+    out = []
+    out.append("// Generated by tools/gen_mesh_tables.py, do not edit")
+    out.append("#ifndef MESH_TABLES_H")
+    out.append("#define MESH_TABLES_H")
+    out.append("")
+    out.append("#include <stdint.h>")
+    out.append('#include "transform.h"')
+    out.append('#include "wire_mesh.h"')
+    out.append("")
+    out.append("#define PARABOLOID_GRID_SIZE %d" % n)
+    out.append("#define PARABOLOID_RANGE     %s" % c_float(RANGE))
+    out.append("#define PARABOLOID_Z_MIN     %s" % c_float(Z_MIN))
+    out.append("#define PARABOLOID_Z_MAX     %s" % c_float(Z_MAX))
+    out.append("")
+    out.append("#define PARABOLOID_LODS      %d" % len(sizes))
+    out.append("")
+    names = []
+    for level, size in enumerate(sizes):
+        name = "paraboloid_heights" if level == 0 else "paraboloid_heights_%d" % level
+        names.append(name)
+        out.append("static const int16_t %s[%d * %d] = {" % (name, size, size))
+        out.append(format_list(["%d" % h for h in paraboloid_heights(size)], 16))
+        out.append("};")
+    out.append("// Grid points per side and heights of each detail level, 0 = full")
+    out.append("static const uint16_t paraboloid_lod_size[PARABOLOID_LODS] = { %s };"
+               % ", ".join("%d" % size for size in sizes))
+    out.append("static const int16_t *const paraboloid_lod_heights[PARABOLOID_LODS] = {")
+    out.append(format_list(names, 4))
+    out.append("};")
+    out.append("")
+    out.append("#define RIPPLE_PEAK          %s" % c_float(RIPPLE_PEAK))
+    out.append("#define RIPPLE_WAVE_PEAK     %s" % c_float(RIPPLE_WAVE_PEAK))
+    out.append("#define RIPPLE_Z_SCALE       ((RIPPLE_PEAK + RIPPLE_WAVE_PEAK) / 32767.0f)")
+    out.append("")
+    names = []
+    for level, size in enumerate(sizes):
+        name = "ripple_modes_%d" % level
+        names.append(name)
+        out.append("static const int16_t %s[%d * %d * 2] = {" % (name, size, size))
+        out.append(format_list(["%d" % m for m in ripple_modes(size)], 16))
+        out.append("};")
+    out.append("// P, Q pairs of the ripple at each detail level (sizes as above)")
+    out.append("static const int16_t *const ripple_lod_modes[PARABOLOID_LODS] = {")
+    out.append(format_list(names, 4))
+    out.append("};")
+    out.append("")
+    out.append("#define CUP_EXTENT_XY %s" % c_float(CUP_EXTENT_XY))
+    out.append("#define CUP_EXTENT_Z  %s" % c_float(CUP_EXTENT_Z))
+    out.append("#define CUP_NUM_VERTICES %d" % len(cup_vertices))
+    out.append("#define CUP_NUM_EDGES    %d" % len(cup_edges))
+    out.append("#define CUP_STRIPS_LEN   %d" % len(cup_strips))
+    out.append("#define CUP_NUM_TRIANGLES %d" % len(cup_triangles))
+    out.append("")
+    out.append("static const Vertex3Ds cup_vertices[CUP_NUM_VERTICES] = {")
+    out.append(format_list(["{ %d, %d, %d }" % v for v in cup_vertices], 4))
+    out.append("};")
+    out.append("static const MeshEdge cup_edges[CUP_NUM_EDGES] = {")
+    out.append(format_list(["{ %d, %d }" % e for e in cup_edges], 8))
+    out.append("};")
+    out.append("static const uint16_t cup_strips[CUP_STRIPS_LEN] = {")
+    out.append(format_list(["0x%04X" % s if s == STRIP_END else "%d" % s for s in cup_strips], 18))
+    out.append("};")
+    out.append("static const uint16_t cup_triangles[CUP_NUM_TRIANGLES * 3] = {")
+    out.append(format_list(["%d, %d, %d" % t for t in cup_triangles], 6))
+    out.append("};")
+    out.append("static const uint16_t cup_edge_faces[CUP_NUM_EDGES * 2] = {")
+    out.append(format_list(["%d, %d" % f for f in cup_edge_faces], 8))
+    out.append("};")
+    out.append("")
+    out.append("#endif // MESH_TABLES_H")
+
+    with open(args.output, "w") as f:
+        f.write("\n".join(out) + "\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,305 @@
+#!/usr/bin/env python3
+"""Convert OBJ / STL meshes to the binary wireframe asset format (.wmsh).
+
+The layout is documented in mesh_asset.h. Faces become a deduplicated edge
+list plus a triangle list (with the one or two triangles next to each edge,
+for back-face culling), OBJ 'l' elements become polyline strips, and
+vertices are quantized to int16 around the bounding box centre. With
+--lods N up to N-1 coarser levels are appended, each built by vertex
+clustering to roughly half the vertex count of the level before.
+
+usage: mesh_convert.py model.obj -o model.wmsh [--lods N]
+"""
+
+import argparse
+import os
+import struct
+
+MAGIC = 0x48534D57  # "WMSH"
+VERSION = 2
+STRIP_END = 0xFFFF
+NO_FACE = 0xFFFF
+MAX_VERTICES = 0xFFFE
+
+LOD_FORMAT = "<6f4H5I"
+HEADER_FORMAT = "<IHH"
+
+
+# ========== Loaders ==========
+
+def load_obj(path):
+    vertices, faces, lines = [], [], []
+
+    def index(tok):
+        i = int(tok.split("/")[0])
+        return i - 1 if i > 0 else len(vertices) + i
+
+    with open(path) as f:
+        for line in f:
+            parts = line.split()
+            if not parts:
+                continue
+            if parts[0] == "v":
+                vertices.append(tuple(float(p) for p in parts[1:4]))
+            elif parts[0] == "f":
+                faces.append([index(p) for p in parts[1:]])
+            elif parts[0] == "l":
+                lines.append([index(p) for p in parts[1:]])
+    return vertices, faces, lines
+
+
+def load_stl(path):
+    with open(path, "rb") as f:
+        data = f.read()
+
+    tris = []
+    count = struct.unpack_from("<I", data, 80)[0] if len(data) >= 84 else 0
+    if len(data) == 84 + count * 50:
+        for k in range(count):
+            vals = struct.unpack_from("<12f", data, 84 + k * 50)
+            tris.append([vals[3:6], vals[6:9], vals[9:12]])
+    else:
+        corner = []
+        for line in data.decode("ascii", "replace").splitlines():
+            parts = line.split()
+            if parts and parts[0] == "vertex":
+                corner.append(tuple(float(p) for p in parts[1:4]))
+                if len(corner) == 3:
+                    tris.append(corner)
+                    corner = []
+
+    # STL repeats shared corners, merge identical positions
+    vertices, lookup, faces = [], {}, []
+    for tri in tris:
+        face = []
+        for p in tri:
+            if p not in lookup:
+                lookup[p] = len(vertices)
+                vertices.append(p)
+            face.append(lookup[p])
+        faces.append(face)
+    return vertices, faces, []
+
+
+# ========== Topology ==========
+
+def clean_polygon(face):
+    out = []
+    for i in face:
+        if not out or out[-1] != i:
+            out.append(i)
+    while len(out) > 1 and out[0] == out[-1]:
+        out.pop()
+    return out
+
+
+def build_edges(faces, strips):
+    in_strips = set()
+    for s in strips:
+        for a, b in zip(s, s[1:]):
+            in_strips.add((min(a, b), max(a, b)))
+
+    seen, edges = set(), []
+    for face in faces:
+        n = len(face)
+        for k in range(n):
+            a, b = face[k], face[(k + 1) % n]
+            key = (min(a, b), max(a, b))
+            if a == b or key in seen or key in in_strips:
+                continue
+            seen.add(key)
+            edges.append(key)
+    return edges
+
+
+def triangulate(faces):
+    tris = []
+    for face in faces:
+        for k in range(1, len(face) - 1):
+            tri = (face[0], face[k], face[k + 1])
+            if len(set(tri)) == 3:
+                tris.append(tri)
+    return tris
+
+
+def build_edge_faces(edges, tris):
+    # The triangles on either side of each edge. Edges of more than two
+    # triangles (non-manifold) get none, so they are never culled.
+    adjacent = {}
+    for t, tri in enumerate(tris):
+        for k in range(3):
+            a, b = tri[k], tri[(k + 1) % 3]
+            adjacent.setdefault((min(a, b), max(a, b)), []).append(t)
+
+    pairs = []
+    for key in edges:
+        faces = adjacent.get(key, [])
+        if len(faces) > 2:
+            faces = []
+        faces = faces + [NO_FACE] * (2 - len(faces))
+        pairs.append(faces)
+    return pairs
+
+
+def compact(vertices, faces, strips):
+    # Drop vertices nothing refers to and renumber the rest
+    used = sorted({i for f in faces for i in f} | {i for s in strips for i in s})
+    remap = {old: new for new, old in enumerate(used)}
+    return ([vertices[i] for i in used],
+            [[remap[i] for i in f] for f in faces],
+            [[remap[i] for i in s] for s in strips])
+
+
+def cluster(vertices, faces, strips, cells):
+    # Vertex clustering on a cells^3 grid over the bounding box: every
+    # vertex moves to the mean of its cell, collapsed faces disappear
+    lo = [min(v[k] for v in vertices) for k in range(3)]
+    hi = [max(v[k] for v in vertices) for k in range(3)]
+    size = [max(hi[k] - lo[k], 1e-9) / cells for k in range(3)]
+
+    cell_of, sums = [], {}
+    for v in vertices:
+        key = tuple(min(int((v[k] - lo[k]) / size[k]), cells - 1) for k in range(3))
+        cell_of.append(key)
+        s = sums.setdefault(key, [0.0, 0.0, 0.0, 0])
+        for k in range(3):
+            s[k] += v[k]
+        s[3] += 1
+
+    keys = list(sums)
+    index = {key: i for i, key in enumerate(keys)}
+    new_vertices = [tuple(sums[key][k] / sums[key][3] for k in range(3)) for key in keys]
+    remap = [index[key] for key in cell_of]
+
+    new_faces, seen = [], set()
+    for f in faces:
+        g = clean_polygon([remap[i] for i in f])
+        if len(g) < 3 or len(set(g)) < len(g):
+            continue
+        key = tuple(sorted(g))
+        if key in seen:
+            continue
+        seen.add(key)
+        new_faces.append(g)
+    new_strips = []
+    for s in strips:
+        g = []
+        for i in s:
+            if not g or g[-1] != remap[i]:
+                g.append(remap[i])
+        if len(g) > 1:
+            new_strips.append(g)
+    return compact(new_vertices, new_faces, new_strips)
+
+
+def decimate(vertices, faces, strips):
+    # Largest clustering grid that at least halves the vertex count
+    target = len(vertices) // 2
+    cells = 64
+    while cells >= 2:
+        lod = cluster(vertices, faces, strips, cells)
+        if len(lod[0]) <= target:
+            return lod
+        cells = cells * 3 // 4
+    return None
+
+
+# ========== Writer ==========
+
+def quantize_params(vertices):
+    lo = [min(v[k] for v in vertices) for k in range(3)]
+    hi = [max(v[k] for v in vertices) for k in range(3)]
+    bias = [(hi[k] + lo[k]) / 2 for k in range(3)]
+    scale = [max((hi[k] - lo[k]) / 2, 1e-6) / 32767.0 for k in range(3)]
+    # float32 round trip so host and device decode with the same values
+    bias = list(struct.unpack("<3f", struct.pack("<3f", *bias)))
+    scale = list(struct.unpack("<3f", struct.pack("<3f", *scale)))
+    return scale, bias
+
+
+def quantize(f, scale, bias):
+    # Same rounding as QUANT_FROM_FLOAT in transform.h
+    v = (f - bias) / scale
+    q = int(v - 0.5) if v < 0 else int(v + 0.5)
+    return max(-32767, min(32767, q))
+
+
+def pad4(buf):
+    buf += b"\0" * (-len(buf) % 4)
+
+
+def write_asset(path, lods):
+    header_size = struct.calcsize(HEADER_FORMAT) + len(lods) * struct.calcsize(LOD_FORMAT)
+    body = bytearray()
+    records = []
+    for vertices, faces, strips in lods:
+        if len(vertices) > MAX_VERTICES:
+            raise SystemExit("%s: %d vertices, at most %d fit uint16 indices"
+                             % (path, len(vertices), MAX_VERTICES))
+        scale, bias = quantize_params(vertices)
+        edges = build_edges(faces, strips)
+        tris = triangulate(faces)
+        edge_faces = build_edge_faces(edges, tris)
+        strip_indices = []
+        for s in strips:
+            strip_indices += s + [STRIP_END]
+
+        offsets = []
+        offsets.append(header_size + len(body))
+        for v in vertices:
+            body += struct.pack("<3h", *(quantize(v[k], scale[k], bias[k]) for k in range(3)))
+        pad4(body)
+        offsets.append(header_size + len(body))
+        for a, b in edges:
+            body += struct.pack("<2H", a, b)
+        offsets.append(header_size + len(body))
+        body += struct.pack("<%dH" % len(strip_indices), *strip_indices)
+        pad4(body)
+        offsets.append(header_size + len(body))
+        for t in tris:
+            body += struct.pack("<3H", *t)
+        pad4(body)
+        offsets.append(header_size + len(body))
+        for f0, f1 in edge_faces:
+            body += struct.pack("<2H", f0, f1)
+
+        records.append(struct.pack(LOD_FORMAT, *scale, *bias,
+                                   len(vertices), len(edges), len(strip_indices), len(tris),
+                                   *offsets))
+
+    with open(path, "wb") as f:
+        f.write(struct.pack(HEADER_FORMAT, MAGIC, VERSION, len(lods)))
+        for r in records:
+            f.write(r)
+        f.write(body)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("input", help="OBJ or STL (ASCII or binary) file")
+    ap.add_argument("-o", "--output", required=True)
+    ap.add_argument("--lods", type=int, default=1, help="maximum number of LOD levels")
+    args = ap.parse_args()
+
+    ext = os.path.splitext(args.input)[1].lower()
+    if ext == ".stl":
+        vertices, faces, lines = load_stl(args.input)
+    else:
+        vertices, faces, lines = load_obj(args.input)
+    faces = [g for g in (clean_polygon(f) for f in faces) if len(g) >= 3]
+    lines = [s for s in lines if len(s) > 1]
+    if not vertices:
+        raise SystemExit("%s: no geometry" % args.input)
+
+    lods = [compact(vertices, faces, lines)]
+    while len(lods) < args.lods:
+        lod = decimate(*lods[-1])
+        if lod is None or not lod[0]:
+            break
+        lods.append(lod)
+
+    write_asset(args.output, lods)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,284 @@
+// 3D transform helpers
+// 三维变换：每帧合成一次旋转矩阵，再批量变换顶点
+//
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include "fast_math.h"
+
+// Numeric backend for vertex storage, rotation and projection:
+//   0 = float
+//   1 = fixed point, Q16.16 coordinates and a Q1.14 rotation matrix, so the
+//       per-vertex work is integer MACs only (RISC-V Hazard3 has no FPU)
+#ifndef GEOM_FIXED_POINT
+#define GEOM_FIXED_POINT 0
+#endif
+
+// Q16.16 / Q1.14 conversion helpers, available with either backend. The
+// FROM_FLOAT forms round to nearest and fold to constants for literal input.
+#define Q16_ONE            (1 << 16)
+#define Q14_ONE            (1 << 14)
+#define Q16_FROM_FLOAT(f)  ((int32_t)((f) * (float)Q16_ONE + ((f) < 0 ? -0.5f : 0.5f)))
+#define Q16_TO_FLOAT(q)    ((float)(q) * (1.0f / Q16_ONE))
+#define Q14_FROM_FLOAT(f)  ((int32_t)((f) * (float)Q14_ONE + ((f) < 0 ? -0.5f : 0.5f)))
+#define Q16_MUL(a, b)      ((int32_t)(((int64_t)(a) * (b)) >> 16))
+// Truncate towards zero, same as a (int) cast of the float value
+#define Q16_TO_INT(q)      ((q) < 0 ? -(-(q) >> 16) : (q) >> 16)
+
+typedef struct {
+    float x, y, z;
+} Vertex3Df;
+
+typedef struct {
+    int32_t x, y, z;    // Q16.16
+} Vertex3Dq;
+
+#if GEOM_FIXED_POINT
+typedef int32_t geom_t;
+typedef Vertex3Dq Vertex3D;
+#define GEOM_FROM_FLOAT(f) Q16_FROM_FLOAT(f)
+#define GEOM_TO_FLOAT(g)   Q16_TO_FLOAT(g)
+#define GEOM_MUL(a, b)     Q16_MUL(a, b)
+#define GEOM_TO_INT(g)     Q16_TO_INT(g)
+#define transform_vertices transform_vertices_q
+#else
+typedef float geom_t;
+typedef Vertex3Df Vertex3D;
+#define GEOM_FROM_FLOAT(f) (f)
+#define GEOM_TO_FLOAT(g)   (g)
+#define GEOM_MUL(a, b)     ((a) * (b))
+#define GEOM_TO_INT(g)     ((int)(g))
+#define transform_vertices transform_vertices_f
+#endif
+
+static inline Vertex3D vertex_from_float(float x, float y, float z) {
+    return (Vertex3D){ GEOM_FROM_FLOAT(x), GEOM_FROM_FLOAT(y), GEOM_FROM_FLOAT(z) };
+}
+
+// ========== Quantized model-space storage ==========
+// Vertices are kept as int16 triples, decoded as v = bias + scale * q per axis.
+// The decode is folded into the per-frame matrix, so it costs nothing per vertex.
+typedef struct {
+    int16_t x, y, z;
+} Vertex3Ds;
+
+typedef struct {
+    Vertex3Df scale;
+    Vertex3Df bias;
+} QuantParams;
+
+// Params for coordinates within +-ex, +-ey, +-ez around the origin
+#define QUANT_PARAMS_EXTENT(ex, ey, ez) \
+    ((QuantParams){ { (ex) / 32767.0f, (ey) / 32767.0f, (ez) / 32767.0f }, { 0.0f, 0.0f, 0.0f } })
+
+// Round (f - bias) / scale to int16; a constant expression for literal input
+#define QUANT_FROM_FLOAT(f, scale, bias) \
+    ((int16_t)(((f) - (bias)) / (scale) + (((f) - (bias)) < 0 ? -0.5f : 0.5f)))
+
+// Quantized inputs are multiplied by coefficients carrying QCOEF_ONE extra
+// scale: with the fixed point backend a coefficient is Q2.30 and the int64
+// product is shifted back to Q16.16, which keeps the precision of scales far
+// below one Q16.16 step. Scales must stay below 2.0 for the Q2.30 range.
+#if GEOM_FIXED_POINT
+#define QCOEF_ONE          ((float)Q14_ONE)
+#define QCOEF_MUL(q, c)    ((int32_t)(((int64_t)(q) * (c)) >> 14))
+#else
+#define QCOEF_ONE          1.0f
+#define QCOEF_MUL(q, c)    ((q) * (c))
+#endif
+
+static inline Vertex3Ds quantize_vertex(const QuantParams *qp, float x, float y, float z) {
+    return (Vertex3Ds){
+        QUANT_FROM_FLOAT(x, qp->scale.x, qp->bias.x),
+        QUANT_FROM_FLOAT(y, qp->scale.y, qp->bias.y),
+        QUANT_FROM_FLOAT(z, qp->scale.z, qp->bias.z),
+    };
+}
+
+// Row-major 3x3 matrix, out = m * v. Always composed in float once per frame;
+// the fixed point kernel converts it to Q1.14 on entry.
+typedef struct {
+    float m[3][3];
+} Mat3;
+
+static inline void mat3_mul(Mat3 *out, const Mat3 *a, const Mat3 *b) {
+    Mat3 r;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            r.m[i][j] = a->m[i][0] * b->m[0][j] +
+                        a->m[i][1] * b->m[1][j] +
+                        a->m[i][2] * b->m[2][j];
+        }
+    }
+    *out = r;
+}
+
+// Compose the per-frame rotation R = Rz * Rx * Ry (same order and sign
+// convention the old per-vertex rotate_vertex() used). Six table lookups per frame.
+static inline void mat3_from_euler(Mat3 *out, float angle_x, float angle_y, float angle_z) {
+    float cos_x = fast_cosf(angle_x), sin_x = fast_sinf(angle_x);
+    float cos_y = fast_cosf(angle_y), sin_y = fast_sinf(angle_y);
+    float cos_z = fast_cosf(angle_z), sin_z = fast_sinf(angle_z);
+
+    const Mat3 ry = {{
+        { cos_y, 0.0f, -sin_y },
+        { 0.0f,  1.0f,  0.0f  },
+        { sin_y, 0.0f,  cos_y },
+    }};
+    const Mat3 rx = {{
+        { 1.0f, 0.0f,   0.0f  },
+        { 0.0f, cos_x, -sin_x },
+        { 0.0f, sin_x,  cos_x },
+    }};
+    const Mat3 rz = {{
+        { cos_z, -sin_z, 0.0f },
+        { sin_z,  cos_z, 0.0f },
+        { 0.0f,   0.0f,  1.0f },
+    }};
+
+    Mat3 rxy;
+    mat3_mul(&rxy, &rx, &ry);
+    mat3_mul(out, &rz, &rxy);
+}
+
+static inline Vertex3Df mat3_apply(const Mat3 *m, Vertex3Df v) {
+    return (Vertex3Df){
+        m->m[0][0] * v.x + m->m[0][1] * v.y + m->m[0][2] * v.z,
+        m->m[1][0] * v.x + m->m[1][1] * v.y + m->m[1][2] * v.z,
+        m->m[2][0] * v.x + m->m[2][1] * v.y + m->m[2][2] * v.z,
+    };
+}
+
+// Batched float kernel: 9 MACs per vertex, matrix held in locals for the whole loop
+static inline void transform_vertices_f(const Vertex3Df *in, Vertex3Df *out, int n, const Mat3 *m) {
+    const float m00 = m->m[0][0], m01 = m->m[0][1], m02 = m->m[0][2];
+    const float m10 = m->m[1][0], m11 = m->m[1][1], m12 = m->m[1][2];
+    const float m20 = m->m[2][0], m21 = m->m[2][1], m22 = m->m[2][2];
+
+    for (int i = 0; i < n; i++) {
+        float x = in[i].x, y = in[i].y, z = in[i].z;
+        out[i].x = m00 * x + m01 * y + m02 * z;
+        out[i].y = m10 * x + m11 * y + m12 * z;
+        out[i].z = m20 * x + m21 * y + m22 * z;
+    }
+}
+
+// Batched fixed point kernel: Q16.16 * Q1.14 accumulated in 64 bits
+// (SMLAL on Cortex-M33, MUL/MULH on Hazard3), rounded back to Q16.16
+static inline void transform_vertices_q(const Vertex3Dq *in, Vertex3Dq *out, int n, const Mat3 *m) {
+    const int32_t m00 = Q14_FROM_FLOAT(m->m[0][0]), m01 = Q14_FROM_FLOAT(m->m[0][1]), m02 = Q14_FROM_FLOAT(m->m[0][2]);
+    const int32_t m10 = Q14_FROM_FLOAT(m->m[1][0]), m11 = Q14_FROM_FLOAT(m->m[1][1]), m12 = Q14_FROM_FLOAT(m->m[1][2]);
+    const int32_t m20 = Q14_FROM_FLOAT(m->m[2][0]), m21 = Q14_FROM_FLOAT(m->m[2][1]), m22 = Q14_FROM_FLOAT(m->m[2][2]);
+    const int64_t round = 1 << 13;
+
+    for (int i = 0; i < n; i++) {
+        int64_t x = in[i].x, y = in[i].y, z = in[i].z;
+        out[i].x = (int32_t)((m00 * x + m01 * y + m02 * z + round) >> 14);
+        out[i].y = (int32_t)((m10 * x + m11 * y + m12 * z + round) >> 14);
+        out[i].z = (int32_t)((m20 * x + m21 * y + m22 * z + round) >> 14);
+    }
+}
+
+// Quantized kernel: out = m * (bias + scale * q). Per frame the scale is folded
+// into the matrix columns and m * bias becomes a translation, leaving 9 MACs
+// per vertex on int16 input.
+static inline void transform_vertices_s16(const Vertex3Ds *in, Vertex3D *out, int n,
+                                          const Mat3 *m, const QuantParams *qp) {
+    const Vertex3Df t = mat3_apply(m, qp->bias);
+    const float sx = qp->scale.x * QCOEF_ONE, sy = qp->scale.y * QCOEF_ONE, sz = qp->scale.z * QCOEF_ONE;
+    const geom_t m00 = GEOM_FROM_FLOAT(m->m[0][0] * sx), m01 = GEOM_FROM_FLOAT(m->m[0][1] * sy), m02 = GEOM_FROM_FLOAT(m->m[0][2] * sz);
+    const geom_t m10 = GEOM_FROM_FLOAT(m->m[1][0] * sx), m11 = GEOM_FROM_FLOAT(m->m[1][1] * sy), m12 = GEOM_FROM_FLOAT(m->m[1][2] * sz);
+    const geom_t m20 = GEOM_FROM_FLOAT(m->m[2][0] * sx), m21 = GEOM_FROM_FLOAT(m->m[2][1] * sy), m22 = GEOM_FROM_FLOAT(m->m[2][2] * sz);
+    const geom_t tx = GEOM_FROM_FLOAT(t.x), ty = GEOM_FROM_FLOAT(t.y), tz = GEOM_FROM_FLOAT(t.z);
+
+    for (int i = 0; i < n; i++) {
+#if GEOM_FIXED_POINT
+        int64_t x = in[i].x, y = in[i].y, z = in[i].z;
+        out[i].x = tx + (int32_t)((m00 * x + m01 * y + m02 * z) >> 14);
+        out[i].y = ty + (int32_t)((m10 * x + m11 * y + m12 * z) >> 14);
+        out[i].z = tz + (int32_t)((m20 * x + m21 * y + m22 * z) >> 14);
+#else
+        float x = in[i].x, y = in[i].y, z = in[i].z;
+        out[i].x = tx + m00 * x + m01 * y + m02 * z;
+        out[i].y = ty + m10 * x + m11 * y + m12 * z;
+        out[i].z = tz + m20 * x + m21 * y + m22 * z;
+#endif
+    }
+}
+
+// Regular height-field grid: vertex (i, j) = (x0 + i*dx, y0 + j*dy, z0 + z_scale * z[i*cols + j]),
+// heights quantized to int16 and stored row-major. z may be NULL for a flat grid at z0.
+// z_min / z_max bound the raw heights, for culling (heightfield_z_range()).
+// dz_i / dz_j bound the height difference between neighbouring points along
+// i and along j, for the hidden-line order (heightfield_z_steps()).
+typedef struct {
+    int rows, cols;
+    geom_t x0, y0, z0;
+    geom_t dx, dy;
+    const int16_t *z;
+    float z_scale;
+    int16_t z_min, z_max;
+    int dz_i, dz_j;
+} HeightField;
+
+static inline void heightfield_z_range(HeightField *hf) {
+    hf->z_min = hf->z_max = 0;
+    if (!hf->z) return;
+    hf->z_min = hf->z_max = hf->z[0];
+    for (int k = 1; k < hf->rows * hf->cols; k++) {
+        if (hf->z[k] < hf->z_min) hf->z_min = hf->z[k];
+        if (hf->z[k] > hf->z_max) hf->z_max = hf->z[k];
+    }
+}
+
+// Largest height difference between neighbouring grid points in direction
+// (di, dj), in raw table units
+static inline int heightfield_max_step(const HeightField *hf, int di, int dj) {
+    if (!hf->z) return 0;
+    int max_step = 0;
+    for (int i = 0; i + di < hf->rows; i++) {
+        const int16_t *z0 = hf->z + i * hf->cols;
+        const int16_t *z1 = z0 + di * hf->cols + dj;
+        for (int j = 0; j + dj < hf->cols; j++) {
+            int d = abs(z1[j] - z0[j]);
+            if (d > max_step) max_step = d;
+        }
+    }
+    return max_step;
+}
+
+// For fixed heights; scans the table, so once and not per frame
+static inline void heightfield_z_steps(HeightField *hf) {
+    hf->dz_i = heightfield_max_step(hf, 1, 0);
+    hf->dz_j = heightfield_max_step(hf, 0, 1);
+}
+
+static inline Vertex3D heightfield_vertex(const HeightField *hf, int i, int j) {
+    geom_t z = hf->z0 + (hf->z ? GEOM_FROM_FLOAT(hf->z_scale * hf->z[i * hf->cols + j]) : 0);
+    return (Vertex3D){ hf->x0 + i * hf->dx, hf->y0 + j * hf->dy, z };
+}
+
+// Forward-differencing transform for height fields. Only the origin and the
+// three basis vectors are rotated; after that every vertex is
+// origin + i*A + j*B + z*C, i.e. adds along the row plus one multiply by the
+// quantized vertex height per output component (C carries z_scale).
+typedef struct {
+    Vertex3D o, a, b, c;
+} HeightFieldBasis;
+
+static inline void heightfield_basis(const HeightField *hf, const Mat3 *m, HeightFieldBasis *basis) {
+    const Vertex3D basis_in[4] = {
+        { hf->x0, hf->y0, hf->z0 },
+        { hf->dx, 0, 0 },
+        { 0, hf->dy, 0 },
+        { 0, 0, GEOM_FROM_FLOAT(hf->z_scale * QCOEF_ONE) },
+    };
+    Vertex3D out[4];
+    transform_vertices(basis_in, out, 4, m);
+    *basis = (HeightFieldBasis){ out[0], out[1], out[2], out[3] };
+}
+
+#endif // TRANSFORM_H
@@ -0,0 +1,282 @@
+// Indexed wireframe meshes
+// 通用线框网格：uint16 索引、去重后的边、折线条带
+//
+#ifndef WIRE_MESH_H
+#define WIRE_MESH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "transform.h"
+#include "simple_gfx.h"
+#include "shade.h"
+#include "camera.h"
+
+// Largest vertex count wire_mesh_project() can cache in one frame
+#ifndef WIRE_MESH_MAX_VERTICES
+#define WIRE_MESH_MAX_VERTICES 512
+#endif
+
+// Largest triangle count back-face culling handles; bigger meshes are drawn
+// without culling
+#ifndef WIRE_MESH_MAX_TRIANGLES
+#define WIRE_MESH_MAX_TRIANGLES 1024
+#endif
+
+// Separates polylines inside WireMesh.strips
+#define WIRE_STRIP_END 0xFFFF
+// No triangle on this side of the edge (WireMesh.edge_faces)
+#define WIRE_NO_FACE 0xFFFF
+
+// One edge, 4 bytes
+typedef struct {
+    uint16_t a, b;
+} MeshEdge;
+
+// Quantized vertices (see QuantParams) plus two kinds of connectivity:
+//   edges  - loose segments
+//   strips - polylines of consecutive indices, each terminated by WIRE_STRIP_END;
+//            a vertex shared by two segments of a strip is read once, and a
+//            strip of n segments costs (n + 2) * 2 bytes
+// Triangles (CCW seen from outside) are optional and not drawn by the
+// wireframe renderer; with edge_faces (the two triangles on either side of
+// each edge) they let it cull the edges on the far side of a closed mesh.
+// Edges without triangles and strips are always drawn.
+typedef struct {
+    const Vertex3Ds *vertices;
+    QuantParams quant;
+    uint16_t num_vertices;
+    const MeshEdge *edges;
+    uint16_t num_edges;
+    const uint16_t *strips;
+    uint16_t strips_len;
+    const uint16_t *triangles;
+    uint16_t num_triangles;
+    const uint16_t *edge_faces;   // 2 per edge, WIRE_NO_FACE where missing
+} WireMesh;
+
+// Which edges wire_mesh_emit() draws
+typedef enum {
+    WIRE_CULL_NONE,           // all of them (see-through)
+    WIRE_CULL_BACK,           // edges of at least one front-facing triangle
+    WIRE_CULL_SILHOUETTE,     // outline only: between a front and a back triangle
+} WireCull;
+
+// ========== Rendering ==========
+// Project rotated vertices to screen (x right / z up) and classify them
+// once; offset moves the scaled vertices in view space (an instance's
+// position, in pixels). depth is the view-space y in pixels.
+static inline void wire_project(const Vertex3D *rotated, int n, geom_t scale, const Vertex3D *offset,
+                                const Camera *cam, ScreenVertex *screen, uint8_t *outcode, int16_t *depth) {
+    for (int i = 0; i < n; i++) {
+        const geom_t y = GEOM_MUL(rotated[i].y, scale) + offset->y;
+        camera_project(cam, GEOM_MUL(rotated[i].x, scale) + offset->x, y,
+                       GEOM_MUL(rotated[i].z, scale) + offset->z, &screen[i]);
+        outcode[i] = gfx_outcode(screen[i].x, screen[i].y);
+        depth[i] = (int16_t)GEOM_TO_INT(y);
+    }
+}
+
+// Per-frame screen cache shared by the wireframe renderer
+static ScreenVertex wire_screen[WIRE_MESH_MAX_VERTICES];
+static uint8_t wire_outcode[WIRE_MESH_MAX_VERTICES];
+static int16_t wire_depth[WIRE_MESH_MAX_VERTICES];
+
+// Frustum test of the mesh's bounding sphere: the box of its quantized
+// range around the (rotated) bias
+static inline CullResult wire_mesh_cull(const WireMesh *mesh, const Mat3 *rot, geom_t scale,
+                                        const Camera *cam) {
+    const QuantParams *qp = &mesh->quant;
+    const float s = GEOM_TO_FLOAT(scale);
+    const Vertex3Df c = mat3_apply(rot, qp->bias);
+    const float ex = qp->scale.x * 32767.0f, ey = qp->scale.y * 32767.0f, ez = qp->scale.z * 32767.0f;
+    return camera_cull_sphere(cam, c.x * s, c.y * s, c.z * s, sqrtf(ex * ex + ey * ey + ez * ez) * s);
+}
+
+// Radius of the sphere around the model origin that holds every vertex, in
+// model units. Rotation does not change it, so it is worked out once per
+// mesh and an instance is culled from its position alone.
+static inline float wire_mesh_radius(const WireMesh *mesh) {
+    const QuantParams *qp = &mesh->quant;
+    float r2 = 0.0f;
+    for (int i = 0; i < mesh->num_vertices; i++) {
+        const Vertex3Ds *v = &mesh->vertices[i];
+        const float x = qp->bias.x + qp->scale.x * v->x;
+        const float y = qp->bias.y + qp->scale.y * v->y;
+        const float z = qp->bias.z + qp->scale.z * v->z;
+        const float d2 = x * x + y * y + z * z;
+        if (d2 > r2) r2 = d2;
+    }
+    return sqrtf(r2);
+}
+
+// Rotate, scale and move every vertex of the mesh into the screen cache
+// once, without culling (the caller has tested the bounds). Returns the
+// number of cached vertices.
+static inline int wire_mesh_transform(const WireMesh *mesh, const Mat3 *rot, geom_t scale,
+                                      const Vertex3D *offset, const Camera *cam) {
+    Vertex3D rotated[64];
+
+    int n = mesh->num_vertices;
+    if (n > WIRE_MESH_MAX_VERTICES) n = WIRE_MESH_MAX_VERTICES;
+    for (int base = 0; base < n; base += 64) {
+        int count = (n - base < 64) ? n - base : 64;
+        transform_vertices_s16(mesh->vertices + base, rotated, count, rot, &mesh->quant);
+        wire_project(rotated, count, scale, offset, cam, wire_screen + base, wire_outcode + base, wire_depth + base);
+    }
+    return n;
+}
+
+// The same for a mesh at the view-space origin, culled first. Returns 0
+// when the mesh is out of view or reaches behind the near plane, so that
+// nothing is drawn.
+static inline int wire_mesh_project(const WireMesh *mesh, const Mat3 *rot, geom_t scale,
+                                    const Camera *cam) {
+    static const Vertex3D origin;
+
+    if (wire_mesh_cull(mesh, rot, scale, cam) >= CULL_NEAR) return 0;
+    return wire_mesh_transform(mesh, rot, scale, &origin, cam);
+}
+
+// ========== 背面剔除 ==========
+// One bit per triangle, set if it faces the viewer this frame
+static uint32_t wire_front[(WIRE_MESH_MAX_TRIANGLES + 31) / 32];
+
+static inline bool wire_is_front(uint16_t f) {
+    return (wire_front[f >> 5] >> (f & 31)) & 1;
+}
+
+// Classify the triangles from their projected corners. The view looks along
+// +y with screen y pointing down (-z), so a triangle CCW seen from outside
+// turns clockwise on screen (negative signed area) when it faces the viewer.
+// Edge-on triangles and those with uncached corners count as front-facing.
+static inline void wire_mesh_classify(const WireMesh *mesh, int n) {
+    const ScreenVertex *screen = wire_screen;
+
+    for (int w = 0; w < (mesh->num_triangles + 31) / 32; w++) wire_front[w] = 0;
+    for (int t = 0; t < mesh->num_triangles; t++) {
+        const uint16_t *tri = &mesh->triangles[3 * t];
+        bool front = true;
+        if (tri[0] < n && tri[1] < n && tri[2] < n) {
+            const ScreenVertex *p0 = &screen[tri[0]], *p1 = &screen[tri[1]], *p2 = &screen[tri[2]];
+            int32_t cross = (int32_t)(p1->x - p0->x) * (p2->y - p0->y) -
+                            (int32_t)(p1->y - p0->y) * (p2->x - p0->x);
+            front = cross <= 0;
+        }
+        if (front) wire_front[t >> 5] |= 1u << (t & 31);
+    }
+}
+
+// Whether edge i survives culling (wire_mesh_classify() done)
+static inline bool wire_edge_visible(const WireMesh *mesh, int i, WireCull cull) {
+    uint16_t f0 = mesh->edge_faces[2 * i], f1 = mesh->edge_faces[2 * i + 1];
+    if (f0 >= mesh->num_triangles) return true;
+    bool front0 = wire_is_front(f0);
+    if (f1 >= mesh->num_triangles) return front0;    // open boundary
+    bool front1 = wire_is_front(f1);
+    return cull == WIRE_CULL_SILHOUETTE ? front0 != front1 : front0 || front1;
+}
+
+// Add the strips to a segment batch from the screen cache
+static inline void wire_mesh_emit_strips(GfxLineBatch *batch, const WireMesh *mesh, int n) {
+    const ScreenVertex *screen = wire_screen;
+    const uint8_t *outcode = wire_outcode;
+
+    uint16_t prev = WIRE_STRIP_END;
+    for (int i = 0; i < mesh->strips_len; i++) {
+        uint16_t cur = mesh->strips[i];
+        if (cur >= n) {
+            prev = WIRE_STRIP_END;
+            continue;
+        }
+        if (prev != WIRE_STRIP_END && !(outcode[prev] & outcode[cur])) {
+            gfx_batch_add(batch, screen[prev].x, screen[prev].y, screen[cur].x, screen[cur].y);
+        }
+        prev = cur;
+    }
+}
+
+// Add the edges and strips to a segment batch from the screen cache filled
+// by wire_mesh_project(), rejecting those entirely off one side of the screen
+// and, unless cull is WIRE_CULL_NONE, those on the far side of the mesh
+static inline void wire_mesh_emit(GfxLineBatch *batch, const WireMesh *mesh, int n, WireCull cull) {
+    const ScreenVertex *screen = wire_screen;
+    const uint8_t *outcode = wire_outcode;
+
+    if (!mesh->edge_faces || mesh->num_triangles > WIRE_MESH_MAX_TRIANGLES) cull = WIRE_CULL_NONE;
+    if (cull != WIRE_CULL_NONE) wire_mesh_classify(mesh, n);
+
+    for (int i = 0; i < mesh->num_edges; i++) {
+        uint16_t a = mesh->edges[i].a, b = mesh->edges[i].b;
+        if (a >= n || b >= n || (outcode[a] & outcode[b])) continue;
+        if (cull != WIRE_CULL_NONE && !wire_edge_visible(mesh, i, cull)) continue;
+        gfx_batch_add(batch, screen[a].x, screen[a].y, screen[b].x, screen[b].y);
+    }
+
+    wire_mesh_emit_strips(batch, mesh, n);
+}
+
+// ========== 填充 ==========
+// Depth buckets of the painter's sort in wire_mesh_emit_filled()
+#define WIRE_DEPTH_BUCKETS 256
+
+// Filled triangles, flat shaded and drawn back to front (painter's
+// algorithm: a counting sort on the summed corner depths), then the strips
+// as lines over them. Faces are two-sided, so open meshes such as the cup
+// show their inside. Meshes without triangles are drawn as wireframes.
+static inline void wire_mesh_emit_filled(GfxLineBatch *batch, const WireMesh *mesh, int n) {
+    static uint16_t order[WIRE_MESH_MAX_TRIANGLES];
+    static uint16_t start[WIRE_DEPTH_BUCKETS + 1];
+    static int32_t key[WIRE_MESH_MAX_TRIANGLES];
+    const ScreenVertex *screen = wire_screen;
+    const uint8_t *outcode = wire_outcode;
+    const int16_t *depth = wire_depth;
+
+    if (!mesh->triangles || mesh->num_triangles > WIRE_MESH_MAX_TRIANGLES) {
+        wire_mesh_emit(batch, mesh, n, WIRE_CULL_BACK);
+        return;
+    }
+
+    // Sort keys; triangles with uncached corners or off one side of the
+    // screen are left out (key -1)
+    const int count = mesh->num_triangles;
+    int32_t kmin = INT32_MAX, kmax = INT32_MIN;
+    for (int t = 0; t < count; t++) {
+        const uint16_t *tri = &mesh->triangles[3 * t];
+        key[t] = -1;
+        if (tri[0] >= n || tri[1] >= n || tri[2] >= n) continue;
+        if (outcode[tri[0]] & outcode[tri[1]] & outcode[tri[2]]) continue;
+        // Offset keeps valid keys non-negative
+        key[t] = depth[tri[0]] + depth[tri[1]] + depth[tri[2]] + 3 * 32768;
+        if (key[t] < kmin) kmin = key[t];
+        if (key[t] > kmax) kmax = key[t];
+    }
+
+    // Farthest (largest depth) first
+    memset(start, 0, sizeof(start));
+    const int32_t range = kmax > kmin ? kmax - kmin + 1 : 1;
+    for (int t = 0; t < count; t++) {
+        if (key[t] < 0) continue;
+        key[t] = (WIRE_DEPTH_BUCKETS - 1) - (key[t] - kmin) * WIRE_DEPTH_BUCKETS / range;
+        start[key[t] + 1]++;
+    }
+    for (int b = 0; b < WIRE_DEPTH_BUCKETS; b++) start[b + 1] += start[b];
+    const int visible = start[WIRE_DEPTH_BUCKETS];
+    for (int t = 0; t < count; t++) {
+        if (key[t] >= 0) order[start[key[t]]++] = t;
+    }
+
+    // Normals from the view-space corners (x, depth, up = -screen y)
+    const ShadeFrame sf = shade_frame_view();
+    for (int k = 0; k < visible; k++) {
+        const uint16_t *tri = &mesh->triangles[3 * order[k]];
+        const ScreenVertex *p0 = &screen[tri[0]], *p1 = &screen[tri[1]], *p2 = &screen[tri[2]];
+        float ax = p1->x - p0->x, ay = depth[tri[1]] - depth[tri[0]], az = p0->y - p1->y;
+        float bx = p2->x - p0->x, by = depth[tri[2]] - depth[tri[0]], bz = p0->y - p2->y;
+        int shade = shade_level(&sf, ay * bz - az * by, az * bx - ax * bz, ax * by - ay * bx);
+        gfx_batch_add_tri(batch, p0->x, p0->y, p1->x, p1->y, p2->x, p2->y, shade);
+    }
+
+    wire_mesh_emit_strips(batch, mesh, n);
+}
+
+#endif // WIRE_MESH_H
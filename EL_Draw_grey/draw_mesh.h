@@ -2,8 +2,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <stdint.h>
+#include <stdbool.h>
 #include "el.h"
-#include "simple_gfx.h"
+#include "gray_gfx.h"
+#include "fast_math.h"
 #include "pico/time.h"
 
 
@@ -17,90 +20,55 @@
 #define SCALE     160/RANGE     
 const uint16_t window_x = 8;
 
+// 1 = anti-aliased edges (draw_line_gray_aa), 0 = aliased, a word at a time
+// (draw_line_gray_fast). Off until the AA line is shown to cost no more per
+// pixel than draw_line_gray on the device (cmake -DGRAY_AA_LINES=ON)
+#ifndef GRAY_AA_LINES
+#define GRAY_AA_LINES 0
+#endif
 
-typedef struct {
-    float x, y, z;
-} Vertex3D;
-
-static void putpixel(unsigned char *buf, int x, int y, int c) {
-    if (x >= 0 && x < SCR_WIDTH && y >= 0 && y < SCR_HEIGHT) {
-        if (c) {
-            buf[SCR_STRIDE * y + x / 8] |= 1 << (x % 8);
-        } else {
-            buf[SCR_STRIDE * y + x / 8] &= ~(1 << (x % 8));
-        }
-    }
-}
-
-
-static void draw_line(unsigned char *buf, int x0, int y0, int x1, int y1) {
-    int dx = abs(x1 - x0);
-    int dy = abs(y1 - y0);
-    int sx = (x0 < x1) ? 1 : -1;
-    int sy = (y0 < y1) ? 1 : -1;
-    int err = dx - dy;
-    
-    while (1) {
-        putpixel(buf, x0, y0, 1);
-        
-        if (x0 == x1 && y0 == y1) break;
-        
-        int e2 = 2 * err;
-        if (e2 > -dy) {
-            err -= dy;
-            x0 += sx;
-        }
-        if (e2 < dx) {
-            err += dx;
-            y0 += sy;
-        }
-    }
-}
-
-static void clear_screen(unsigned char *buf) {
-    memset(buf, 0, SCR_STRIDE * SCR_HEIGHT);
-}
 
+// Heights of the grid; x and y follow from the grid position
+static float heights[GRID_SIZE * GRID_SIZE];
 
-static Vertex3D paraboloid_vertices[GRID_SIZE * GRID_SIZE];
-static Vertex3D base_vertices[GRID_SIZE * GRID_SIZE];
-static int edge_count;
-static int edges[2 * GRID_SIZE * (GRID_SIZE - 1) * 2][2]; // 行线+列线
-static Vertex3D rotated_paraboloid[GRID_SIZE * GRID_SIZE];
-static Vertex3D rotated_base[GRID_SIZE * GRID_SIZE];
+// Per-frame projection: screen position and depth (rotated y, larger is
+// farther) of every grid point
+static int16_t screen_x[GRID_SIZE * GRID_SIZE];
+static int16_t screen_y[GRID_SIZE * GRID_SIZE];
+static int16_t depth[GRID_SIZE * GRID_SIZE];
 
 
 float angle_x = 0.15f;
 float angle_y = 0.15f;
 float angle_z = 0.15f;
-float speed = 0.03f;
+float speed = 0.9f;        // rad/s about x, y and z turn 1.5 and 0.7 times as fast
 
 
-void draw_ui_elements(unsigned char *buffer);
+void draw_ui_elements(unsigned char *gray_buf);
 
 float calculate_zx(float u, float v) {
-    float r = sqrt(u * u + v * v); 
+    float r = fast_sqrtf(u * u + v * v);
     
     if (r == 0.0f) {
         return 1.0f;  
     } else {
-        return 5*sin(r) / r;
+        return 5*fast_sincf(r);
     }
 }
 
 
 void rotate_vertex(float x, float y, float z, float* out_x, float* out_y, float* out_z) {
-    float cos_y = cosf(angle_y), sin_y = sinf(angle_y);
+    float cos_y = fast_cosf(angle_y), sin_y = fast_sinf(angle_y);
     float x1 = x * cos_y - z * sin_y;
     float z1 = x * sin_y + z * cos_y;
     float y1 = y;
 
-    float cos_x = cosf(angle_x), sin_x = sinf(angle_x);
+    float cos_x = fast_cosf(angle_x), sin_x = fast_sinf(angle_x);
     float y2 = y1 * cos_x - z1 * sin_x;
     float z2 = y1 * sin_x + z1 * cos_x;
     float x2 = x1;
 
-    float cos_z = cosf(angle_z), sin_z = sinf(angle_z);
+    float cos_z = fast_cosf(angle_z), sin_z = fast_sinf(angle_z);
     float x3 = x2 * cos_z - y2 * sin_z;
     float y3 = x2 * sin_z + y2 * cos_z;
     float z3 = z2;
@@ -111,128 +79,134 @@ void rotate_vertex(float x, float y, float z, float* out_x, float* out_y, float*
 }
 
 
-void project_to_screen(float x, float y, float z, int16_t* screen_x, int16_t* screen_y) {
-    *screen_x = CENTER_X + (int16_t)(x * SCALE);
-    *screen_y = CENTER_Y - (int16_t)(z * SCALE);
-}
-
 void init_mesh() {
     for (int i = 0; i < GRID_SIZE; i++) {
         for (int j = 0; j < GRID_SIZE; j++) {
             float x = -RANGE + (2.0f * RANGE) * i / (GRID_SIZE - 1);
             float y = -RANGE + (2.0f * RANGE) * j / (GRID_SIZE - 1);
-            float z_paraboloid = calculate_zx(x,y);
-            float z_base = -2.0f;
-
-            int idx = i * GRID_SIZE + j;
-            paraboloid_vertices[idx] = (Vertex3D){x, y, z_paraboloid};
-            base_vertices[idx] = (Vertex3D){x, y, z_base};
-        }
-    }
-
-    edge_count = 0;
-
-    for (int j = 0; j < GRID_SIZE; j++) {
-        for (int i = 0; i < GRID_SIZE - 1; i++) {
-            int idx1 = i + j * GRID_SIZE;
-            int idx2 = i + 1 + j * GRID_SIZE;
-            edges[edge_count][0] = idx1;
-            edges[edge_count][1] = idx2;
-            edge_count++;
+            heights[i * GRID_SIZE + j] = calculate_zx(x, y);
         }
     }
+}
 
+// ========== 投影 ==========
+// Only the grid origin and the three axes are rotated; every grid point is
+// then o + i * a + j * b + z * c, already scaled to pixels
+static void project_grid(int16_t *dmin, int16_t *dmax) {
+    const float step = (2.0f * RANGE) / (GRID_SIZE - 1);
+    float ox, oy, oz, ax, ay, az, bx, by, bz, cx, cy, cz;
+    rotate_vertex(-RANGE * SCALE, -RANGE * SCALE, 0.0f, &ox, &oy, &oz);
+    rotate_vertex(step * SCALE, 0.0f, 0.0f, &ax, &ay, &az);
+    rotate_vertex(0.0f, step * SCALE, 0.0f, &bx, &by, &bz);
+    rotate_vertex(0.0f, 0.0f, SCALE, &cx, &cy, &cz);
+
+    int16_t lo = INT16_MAX, hi = INT16_MIN;
     for (int i = 0; i < GRID_SIZE; i++) {
-        for (int j = 0; j < GRID_SIZE - 1; j++) {
-            int idx1 = i + j * GRID_SIZE;
-            int idx2 = i + (j + 1) * GRID_SIZE;
-            edges[edge_count][0] = idx1;
-            edges[edge_count][1] = idx2;
-            edge_count++;
+        float px = ox + i * ax, py = oy + i * ay, pz = oz + i * az;
+        for (int j = 0; j < GRID_SIZE; j++) {
+            const int idx = i * GRID_SIZE + j;
+            const float z = heights[idx];
+            screen_x[idx] = CENTER_X + (int16_t)(px + z * cx);
+            screen_y[idx] = CENTER_Y - (int16_t)(pz + z * cz);
+            const int16_t d = (int16_t)(py + z * cy);
+            depth[idx] = d;
+            if (d < lo) lo = d;
+            if (d > hi) hi = d;
+            px += bx;
+            py += by;
+            pz += bz;
         }
     }
+    *dmin = lo;
+    *dmax = hi;
 }
 
-void draw_frame() {
-
-    unsigned char *buffer = el_get_draw_buffer();
-    clear_screen(buffer);
-
-    for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
-        float rx, ry, rz;
-        rotate_vertex(
-            paraboloid_vertices[i].x,
-            paraboloid_vertices[i].y,
-            paraboloid_vertices[i].z,
-            &rx, &ry, &rz
-        );
-        rotated_paraboloid[i] = (Vertex3D){rx, ry, rz};
-    }
-
-    for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
-        float rx, ry, rz;
-        rotate_vertex(
-            base_vertices[i].x,
-            base_vertices[i].y,
-            base_vertices[i].z,
-            &rx, &ry, &rz
-        );
-        rotated_base[i] = (Vertex3D){rx, ry, rz};
-    }
-
-    for (int i = 0; i < edge_count; i++) {
-        int v1_idx = edges[i][0];
-        int v2_idx = edges[i][1];
-
-        if (v1_idx >= GRID_SIZE * GRID_SIZE || v2_idx >= GRID_SIZE * GRID_SIZE) continue;
-
-        int16_t x1, y1, x2, y2;
+// ========== 深度提示 ==========
+// The depth of an edge's midpoint picks its gray level: the nearest third
+// of the surface is drawn at 3, the middle at 2 and the farthest at 1.
+// depth_sum is the sum of both ends' depths; inv is 3 * 2^16 / range of
+// the sum, so the level takes a multiply instead of a divide.
+static inline uint8_t depth_gray(int32_t depth_sum, int32_t sum_min, int32_t inv) {
+    int32_t t = ((depth_sum - sum_min) * inv) >> 16;
+    return t >= 2 ? 1 : 3 - t;
+}
 
-        project_to_screen(
-            rotated_paraboloid[v1_idx].x,
-            rotated_paraboloid[v1_idx].y,
-            rotated_paraboloid[v1_idx].z,
-            &x1, &y1
-        );
-        project_to_screen(
-            rotated_paraboloid[v2_idx].x,
-            rotated_paraboloid[v2_idx].y,
-            rotated_paraboloid[v2_idx].z,
-            &x2, &y2
-        );
+// Edges with an end off screen are clipped, not dropped, so the mesh runs
+// right up to the border; only an edge wholly beyond one screen side is culled
+static void draw_edge(unsigned char *gray_buf, int a, int b, int32_t sum_min, int32_t inv) {
+    int x0 = screen_x[a], y0 = screen_y[a], x1 = screen_x[b], y1 = screen_y[b];
+    const uint8_t c0 = gray_outcode(x0, y0), c1 = gray_outcode(x1, y1);
+    if (c0 & c1) return;
+    const uint8_t level = depth_gray(depth[a] + depth[b], sum_min, inv);
+#if GRAY_AA_LINES
+    // draw_line_gray_aa clips along the exact line itself
+    draw_line_gray_aa(gray_buf, x0, y0, x1, y1, level);
+#else
+    if ((c0 | c1) && !gray_clip_line_oc(&x0, &y0, c0, &x1, &y1, c1)) return;
+    draw_line_gray_fast(gray_buf, x0, y0, x1, y1, level);
+#endif
+}
 
-        if (x1 < 0 || x1 >= SCREEN_WIDTH || y1 < 0 || y1 >= SCREEN_HEIGHT) continue;
-        if (x2 < 0 || x2 >= SCREEN_WIDTH || y2 < 0 || y2 >= SCREEN_HEIGHT) continue;
+// Turn by the time since the last frame, so the speed does not depend on
+// the frame rate
+static void advance_angles() {
+    static uint32_t last_us;
+    const uint32_t now = time_us_32();
+    float dt = last_us ? (now - last_us) * 1e-6f : 0.0f;
+    if (dt > 0.1f) dt = 0.1f;
+    last_us = now;
 
-        draw_line(buffer, x1, y1, x2, y2);
-    }
-    
-    draw_ui_elements(buffer);
-    
-    angle_x += speed;
+    angle_x += speed * dt;
     if (angle_x > 2 * M_PI) angle_x -= 2 * M_PI;
     
-    angle_y += speed * 1.5f;
+    angle_y += speed * 1.5f * dt;
     if (angle_y > 2 * M_PI) angle_y -= 2 * M_PI;
     
-    angle_z += speed * 0.7f;
+    angle_z += speed * 0.7f * dt;
     if (angle_z > 2 * M_PI) angle_z -= 2 * M_PI;
 }
 
-void draw_ui_elements(unsigned char *buffer) {
+void draw_frame() {
+    unsigned char *gray_buf = el_get_gray_buffer();
+    clear_gray_screen(gray_buf, 0);
+
+    int16_t dmin, dmax;
+    project_grid(&dmin, &dmax);
+    const int32_t sum_min = 2 * dmin;
+    const int32_t inv = (3 << 16) / (2 * (dmax - dmin) + 1);
+
+    // Grid lines along j, then along i
+    for (int i = 0; i < GRID_SIZE; i++) {
+        for (int j = 0; j < GRID_SIZE - 1; j++) {
+            const int idx = i * GRID_SIZE + j;
+            draw_edge(gray_buf, idx, idx + 1, sum_min, inv);
+        }
+    }
+    for (int i = 0; i < GRID_SIZE - 1; i++) {
+        for (int j = 0; j < GRID_SIZE; j++) {
+            const int idx = i * GRID_SIZE + j;
+            draw_edge(gray_buf, idx, idx + GRID_SIZE, sum_min, inv);
+        }
+    }
+    
+    draw_ui_elements(gray_buf);
+    advance_angles();
+}
+
+void draw_ui_elements(unsigned char *gray_buf) {
     const char* title = "3D DEMO";
     int title_width = strlen(title) * 6 * 3; 
     int title_x = (SCREEN_WIDTH - title_width) / 2;
     int title_y = 10;
-    gfx_draw_string(buffer, title_x, title_y, title, 3);
+    draw_string_gray(gray_buf, title_x, title_y, title, 3, 3);
     
-    gfx_draw_rect(buffer, title_x - 10, title_y - 5, title_width + 20, 25, false);
+    draw_rect_gray(gray_buf, title_x - 10, title_y - 5, title_width + 20, 25, 2);
     
-    gfx_draw_circle(buffer, 20, 20, 8, false);
-    gfx_draw_circle(buffer, 20, 20, 4, true);
+    draw_circle_gray(gray_buf, 20, 20, 8, 2);
+    fill_circle_gray(gray_buf, 20, 20, 4, 3);
     
-    gfx_draw_circle(buffer, SCREEN_WIDTH - 20, 20, 8, false);
-    gfx_draw_circle(buffer, SCREEN_WIDTH - 20, 20, 4, true);
+    draw_circle_gray(gray_buf, SCREEN_WIDTH - 20, 20, 8, 2);
+    fill_circle_gray(gray_buf, SCREEN_WIDTH - 20, 20, 4, 3);
     
     char info_text[64];
 
@@ -262,16 +236,16 @@ void draw_ui_elements(unsigned char *buffer) {
     } else {
         snprintf(info_text, sizeof(info_text), "FPS: %.1f", current_fps);
     }
-    gfx_draw_string(buffer, 10, SCREEN_HEIGHT - 20, info_text, 1);
+    draw_string_gray(gray_buf, 10, SCREEN_HEIGHT - 20, info_text, 1, 3);
     
     snprintf(info_text, sizeof(info_text), "Grid: %dx%d", GRID_SIZE, GRID_SIZE);
     int info_width = strlen(info_text) * 6; 
-    gfx_draw_string(buffer, SCREEN_WIDTH - info_width - 10, SCREEN_HEIGHT - 20, info_text, 1);
+    draw_string_gray(gray_buf, SCREEN_WIDTH - info_width - 10, SCREEN_HEIGHT - 20, info_text, 1, 3);
     
     const char* controls = "Raspberry Pi Pico 3D Graphics Demo";
     int controls_width = strlen(controls) * 6;
     int controls_x = (SCREEN_WIDTH - controls_width) / 2;
-    gfx_draw_string(buffer, controls_x, SCREEN_HEIGHT - 40, controls, 1);
+    draw_string_gray(gray_buf, controls_x, SCREEN_HEIGHT - 40, controls, 1, 2);
 }
 
 void deinit_mesh() {
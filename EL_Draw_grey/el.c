@@ -34,13 +34,15 @@ PIO el_pio = pio0;
 
 int el_udma_chan, el_ldma_chan;
 
+// Word aligned: DMA reads and the line rasterizer write them as uint32_t
 // Gray buffer stores 2-bit grayscale values (0-3) for each pixel
-unsigned char gray_framebuf[SCR_STRIDE * SCR_HEIGHT * 2];
-// Binary frame buffers for temporal dithering (4 frames for 4-level gray)
-unsigned char binary_framebuf[GRAYSCALE_FRAMES][SCR_STRIDE * SCR_HEIGHT];
+unsigned char gray_framebuf[SCR_STRIDE * SCR_HEIGHT * 2] __attribute__((aligned(4)));
+// Binary frame buffers for temporal dithering (4 frames for 4-level gray),
+// two sets: one is scanned out while the next frame is converted into the other
+unsigned char binary_framebuf[2][GRAYSCALE_FRAMES][SCR_STRIDE * SCR_HEIGHT] __attribute__((aligned(4)));
 
 static int frame_counter = 0; // Current frame in the 4-frame cycle (0-3)
-static int draw_frame_index = 0; // Which frame set is being drawn
+static volatile int draw_frame_index = 1; // Which frame set is being drawn (converted into)
 volatile int frame_scroll_lines = 0;
 volatile bool swap_buffer = false;
 
@@ -81,14 +83,16 @@ static void el_dma_config_chainning(uint chan, uint chain_to) {
 static void el_pio_irq_handler() {
     gpio_put(25, 1);
     
-    // Use the current frame in the 4-frame cycle
-    uint8_t *framebuf = binary_framebuf[frame_counter];
+    // Use the current frame in the 4-frame cycle of the shown set
+    uint8_t *framebuf = binary_framebuf[!draw_frame_index][frame_counter];
     
     // Advance to next frame in the cycle
     frame_counter = (frame_counter + 1) % GRAYSCALE_FRAMES;
     
-    // Check if buffer swap is requested (happens after all 4 frames displayed)
+    // Check if buffer swap is requested (happens after all 4 frames displayed):
+    // the next cycle shows the set just converted
     if (swap_buffer && frame_counter == 0) {
+        draw_frame_index = !draw_frame_index;
         swap_buffer = false;
     }
 
@@ -182,80 +186,66 @@ static void el_dma_init() {
 // Grayscale value 3 (11): 4 frames ON (100%)
 // 
 // 优化方案：使用空间抖动减少25%亮度的闪烁
-// 对于25%灰度，不是所有像素都用相同的时间模式，而是空间分布
+// 对于25%灰度，不是所有像素都用相同的时间模式，而是空间分布：
+// 像素 (x, y) 在第 (x + y) % 4 帧点亮
+//
+// 查表转换：一个灰度字节是 4 个像素，x 是 4 的倍数，所以 25% 的相位只取决于
+// y % 4。gray_nibbles[y % 4][字节] 给出 4 帧各自的 4 位（第 f 帧在 bit 4f..4f+3，
+// 像素 0 在高位，和二值帧的 bit 7 - x % 8 一致），两个灰度字节拼成一个二值字节，
+// 每帧按 32 位字写出，不需要先清零
+static uint16_t gray_nibbles[4][256];
+
+static void init_gray_nibbles() {
+    for (int phase = 0; phase < 4; phase++) {
+        for (int g = 0; g < 256; g++) {
+            uint16_t v = 0;
+            for (int k = 0; k < 4; k++) {
+                int gray_value = (g >> ((3 - k) * 2)) & 0x03;
+                for (int frame = 0; frame < GRAYSCALE_FRAMES; frame++) {
+                    bool on = gray_value == 3 ||
+                              (gray_value == 2 && (frame & 1) == 0) ||
+                              (gray_value == 1 && (k + phase) % 4 == frame);
+                    if (on) v |= 1 << (4 * frame + 3 - k);
+                }
+            }
+            gray_nibbles[phase][g] = v;
+        }
+    }
+}
+
 static void convert_gray_to_binary() {
-    // Temporal dithering patterns for each grayscale level
-    // Pattern indicates which frames should be lit (1) or dark (0)
-    // 为了减少闪烁，25%灰度使用4种不同的时间模式，空间分布
-    static const uint8_t dither_pattern[4][4] = {
-        {0, 0, 0, 0},  // Level 0: 0% - all OFF
-        {1, 0, 0, 0},  // Level 1: 25% - 1/4 frames ON (将用4种模式轮换)
-        {1, 0, 1, 0},  // Level 2: 50% - 2/4 frames ON (交替)
-        {1, 1, 1, 1}   // Level 3: 100% - all ON (修改为全亮)
-    };
-    
-    // 25%灰度的4种时间模式（空间分布以减少闪烁）
-    static const uint8_t dither_pattern_25[4][4] = {
-        {1, 0, 0, 0},  // 第0帧亮
-        {0, 1, 0, 0},  // 第1帧亮
-        {0, 0, 1, 0},  // 第2帧亮
-        {0, 0, 0, 1}   // 第3帧亮
-    };
-    
+    const uint32_t *src = (const uint32_t *)gray_framebuf;
+    uint32_t *dst[GRAYSCALE_FRAMES];
     for (int frame = 0; frame < GRAYSCALE_FRAMES; frame++) {
-        memset(binary_framebuf[frame], 0, SCR_STRIDE * SCR_HEIGHT);
+        dst[frame] = (uint32_t *)binary_framebuf[draw_frame_index][frame];
     }
-    
-    // Process each pixel
+
     for (int y = 0; y < SCR_HEIGHT; y++) {
-        for (int x = 0; x < SCR_WIDTH; x++) {
-            // Calculate byte and bit position in gray buffer
-            int pixel_index = y * SCR_WIDTH + x;
-            int byte_index = pixel_index / 4; // 4 pixels per byte (2 bits each)
-            int pixel_in_byte = pixel_index % 4;
-            int bit_shift = (3 - pixel_in_byte) * 2; // 6, 4, 2, 0
-            
-            // Extract 2-bit gray value
-            uint8_t gray_value = (gray_framebuf[byte_index] >> bit_shift) & 0x03;
-            
-            // Calculate binary frame data
-            int bin_byte = y * SCR_STRIDE + x / 8;
-            int bin_bit = 7 - (x % 8);
-            
-            if (gray_value == 0) {
-                // 全黑：不做任何操作（已经memset为0）
-                continue;
-            } else if (gray_value == 1) {
-                // 25%灰度：使用空间抖动减少闪烁
-                // 根据像素位置选择不同的时间模式
-                int pattern_index = (x + y) % 4;  // 2x2 Bayer模式
-                for (int frame = 0; frame < GRAYSCALE_FRAMES; frame++) {
-                    if (dither_pattern_25[pattern_index][frame]) {
-                        binary_framebuf[frame][bin_byte] |= (1 << bin_bit);
+        const uint16_t *lut = gray_nibbles[y & 3];
+        // 32 pixels: 8 gray bytes in, one word out per frame
+        for (int w = 0; w < SCR_STRIDE_WORDS; w++) {
+            uint32_t out[GRAYSCALE_FRAMES] = { 0 };
+            for (int half = 0; half < 2; half++) {
+                uint32_t g = *src++;
+                for (int b = 0; b < 4; b += 2) {
+                    uint32_t hi = lut[(g >> (8 * b)) & 0xff];
+                    uint32_t lo = lut[(g >> (8 * b + 8)) & 0xff];
+                    int shift = 16 * half + 4 * b;
+                    for (int frame = 0; frame < GRAYSCALE_FRAMES; frame++) {
+                        uint32_t byte = (((hi >> (4 * frame)) & 0xf) << 4) | ((lo >> (4 * frame)) & 0xf);
+                        out[frame] |= byte << shift;
                     }
                 }
-            } else if (gray_value == 2) {
-                // 50%灰度：交替模式
-                for (int frame = 0; frame < GRAYSCALE_FRAMES; frame++) {
-                    if (dither_pattern[2][frame]) {
-                        binary_framebuf[frame][bin_byte] |= (1 << bin_bit);
-                    }
-                }
-            } else {
-                // 100%灰度：全部点亮
-                for (int frame = 0; frame < GRAYSCALE_FRAMES; frame++) {
-                    binary_framebuf[frame][bin_byte] |= (1 << bin_bit);
-                }
             }
+            for (int frame = 0; frame < GRAYSCALE_FRAMES; frame++) *dst[frame]++ = out[frame];
         }
     }
 }
 
 void el_start() {
+    init_gray_nibbles();
     memset(gray_framebuf, 0x00, sizeof(gray_framebuf));
-    for (int i = 0; i < GRAYSCALE_FRAMES; i++) {
-        memset(binary_framebuf[i], 0x00, SCR_STRIDE * SCR_HEIGHT);
-    }
+    memset(binary_framebuf, 0x00, sizeof(binary_framebuf));
 
     el_sm_init();
     el_dma_init();
@@ -264,7 +254,8 @@ void el_start() {
 
 void el_swap_buffer() {
     swap_buffer = true;
-    // Wait until all 4 frames have been displayed
+    // Wait until all 4 frames of the shown set have been displayed and the
+    // converted set has taken its place
     while (swap_buffer);
 }
 
@@ -272,6 +263,7 @@ unsigned char *el_get_gray_buffer() {
     return gray_framebuf;
 }
 
+// Convert into the set not being shown; it is shown after el_swap_buffer()
 void el_update_frame() {
     convert_gray_to_binary();
 }
@@ -56,7 +56,7 @@
 // Public variables and functions
 // Gray buffer stores 2-bit grayscale values (0-3)
 extern unsigned char gray_framebuf[SCR_STRIDE * SCR_HEIGHT * 2]; // 2 bits per pixel
-extern unsigned char binary_framebuf[GRAYSCALE_FRAMES][SCR_STRIDE * SCR_HEIGHT];
+extern unsigned char binary_framebuf[2][GRAYSCALE_FRAMES][SCR_STRIDE * SCR_HEIGHT];
 extern volatile int frame_scroll_lines;
 extern volatile bool swap_buffer;
 
@@ -0,0 +1,104 @@
+// Fast math approximations
+// 快速数学函数：查表插值 sin/cos、快速平方根倒数、sinc
+//
+// Max errors (measured against the libm float versions):
+//   fast_sinf / fast_cosf  abs error <= 7.6e-5 for |x| <= 64 rad, <= 1.2e-4 for
+//                          |x| <= 1000 rad (float rounding of the argument dominates)
+//   fast_rsqrtf            rel error <= 4.8e-6 for x > 0
+//   fast_sqrtf             rel error <= 4.8e-6 for x >= 0
+//   fast_sincf             abs error <= 7.3e-5 for |x| <= 64
+//
+#ifndef FAST_MATH_H
+#define FAST_MATH_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#define FAST_SIN_TABLE_BITS 8
+#define FAST_SIN_TABLE_SIZE (1 << FAST_SIN_TABLE_BITS)
+
+// sin(2*pi*i/256) for i = 0..256, the extra entry saves a wrap in the interpolation
+static const float fast_sin_table[FAST_SIN_TABLE_SIZE + 1] = {
+    0.00000000f, 0.02454123f, 0.04906767f, 0.07356456f, 0.09801714f, 0.12241068f, 0.14673047f, 0.17096189f,
+    0.19509032f, 0.21910124f, 0.24298018f, 0.26671276f, 0.29028468f, 0.31368174f, 0.33688985f, 0.35989504f,
+    0.38268343f, 0.40524131f, 0.42755509f, 0.44961133f, 0.47139674f, 0.49289819f, 0.51410274f, 0.53499762f,
+    0.55557023f, 0.57580819f, 0.59569930f, 0.61523159f, 0.63439328f, 0.65317284f, 0.67155895f, 0.68954054f,
+    0.70710678f, 0.72424708f, 0.74095113f, 0.75720885f, 0.77301045f, 0.78834643f, 0.80320753f, 0.81758481f,
+    0.83146961f, 0.84485357f, 0.85772861f, 0.87008699f, 0.88192126f, 0.89322430f, 0.90398929f, 0.91420976f,
+    0.92387953f, 0.93299280f, 0.94154407f, 0.94952818f, 0.95694034f, 0.96377607f, 0.97003125f, 0.97570213f,
+    0.98078528f, 0.98527764f, 0.98917651f, 0.99247953f, 0.99518473f, 0.99729046f, 0.99879546f, 0.99969882f,
+    1.00000000f, 0.99969882f, 0.99879546f, 0.99729046f, 0.99518473f, 0.99247953f, 0.98917651f, 0.98527764f,
+    0.98078528f, 0.97570213f, 0.97003125f, 0.96377607f, 0.95694034f, 0.94952818f, 0.94154407f, 0.93299280f,
+    0.92387953f, 0.91420976f, 0.90398929f, 0.89322430f, 0.88192126f, 0.87008699f, 0.85772861f, 0.84485357f,
+    0.83146961f, 0.81758481f, 0.80320753f, 0.78834643f, 0.77301045f, 0.75720885f, 0.74095113f, 0.72424708f,
+    0.70710678f, 0.68954054f, 0.67155895f, 0.65317284f, 0.63439328f, 0.61523159f, 0.59569930f, 0.57580819f,
+    0.55557023f, 0.53499762f, 0.51410274f, 0.49289819f, 0.47139674f, 0.44961133f, 0.42755509f, 0.40524131f,
+    0.38268343f, 0.35989504f, 0.33688985f, 0.31368174f, 0.29028468f, 0.26671276f, 0.24298018f, 0.21910124f,
+    0.19509032f, 0.17096189f, 0.14673047f, 0.12241068f, 0.09801714f, 0.07356456f, 0.04906767f, 0.02454123f,
+    0.00000000f, -0.02454123f, -0.04906767f, -0.07356456f, -0.09801714f, -0.12241068f, -0.14673047f, -0.17096189f,
+    -0.19509032f, -0.21910124f, -0.24298018f, -0.26671276f, -0.29028468f, -0.31368174f, -0.33688985f, -0.35989504f,
+    -0.38268343f, -0.40524131f, -0.42755509f, -0.44961133f, -0.47139674f, -0.49289819f, -0.51410274f, -0.53499762f,
+    -0.55557023f, -0.57580819f, -0.59569930f, -0.61523159f, -0.63439328f, -0.65317284f, -0.67155895f, -0.68954054f,
+    -0.70710678f, -0.72424708f, -0.74095113f, -0.75720885f, -0.77301045f, -0.78834643f, -0.80320753f, -0.81758481f,
+    -0.83146961f, -0.84485357f, -0.85772861f, -0.87008699f, -0.88192126f, -0.89322430f, -0.90398929f, -0.91420976f,
+    -0.92387953f, -0.93299280f, -0.94154407f, -0.94952818f, -0.95694034f, -0.96377607f, -0.97003125f, -0.97570213f,
+    -0.98078528f, -0.98527764f, -0.98917651f, -0.99247953f, -0.99518473f, -0.99729046f, -0.99879546f, -0.99969882f,
+    -1.00000000f, -0.99969882f, -0.99879546f, -0.99729046f, -0.99518473f, -0.99247953f, -0.98917651f, -0.98527764f,
+    -0.98078528f, -0.97570213f, -0.97003125f, -0.96377607f, -0.95694034f, -0.94952818f, -0.94154407f, -0.93299280f,
+    -0.92387953f, -0.91420976f, -0.90398929f, -0.89322430f, -0.88192126f, -0.87008699f, -0.85772861f, -0.84485357f,
+    -0.83146961f, -0.81758481f, -0.80320753f, -0.78834643f, -0.77301045f, -0.75720885f, -0.74095113f, -0.72424708f,
+    -0.70710678f, -0.68954054f, -0.67155895f, -0.65317284f, -0.63439328f, -0.61523159f, -0.59569930f, -0.57580819f,
+    -0.55557023f, -0.53499762f, -0.51410274f, -0.49289819f, -0.47139674f, -0.44961133f, -0.42755509f, -0.40524131f,
+    -0.38268343f, -0.35989504f, -0.33688985f, -0.31368174f, -0.29028468f, -0.26671276f, -0.24298018f, -0.21910124f,
+    -0.19509032f, -0.17096189f, -0.14673047f, -0.12241068f, -0.09801714f, -0.07356456f, -0.04906767f, -0.02454123f,
+    0.00000000f,
+};
+
+// Table lookup with linear interpolation. t is the angle in table units
+// (FAST_SIN_TABLE_SIZE per turn).
+static inline float fast_sin_turns(float t) {
+    int32_t i = (int32_t)t;
+    if ((float)i > t) i--;      // floor for negative angles
+    float frac = t - (float)i;
+    i &= FAST_SIN_TABLE_SIZE - 1;
+    float a = fast_sin_table[i];
+    return a + frac * (fast_sin_table[i + 1] - a);
+}
+
+static inline float fast_sinf(float x) {
+    return fast_sin_turns(x * (FAST_SIN_TABLE_SIZE / (2.0f * (float)M_PI)));
+}
+
+static inline float fast_cosf(float x) {
+    return fast_sin_turns(x * (FAST_SIN_TABLE_SIZE / (2.0f * (float)M_PI)) + FAST_SIN_TABLE_SIZE / 4);
+}
+
+// Bit-trick initial guess refined with two Newton steps
+static inline float fast_rsqrtf(float x) {
+    float half = 0.5f * x;
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    bits = 0x5f375a86u - (bits >> 1);
+    float y;
+    memcpy(&y, &bits, sizeof(y));
+    y = y * (1.5f - half * y * y);
+    y = y * (1.5f - half * y * y);
+    return y;
+}
+
+static inline float fast_sqrtf(float x) {
+    return x > 0.0f ? x * fast_rsqrtf(x) : 0.0f;
+}
+
+// sin(x) / x, with a Taylor series near zero where the table error would be
+// amplified by the division
+static inline float fast_sincf(float x) {
+    float x2 = x * x;
+    if (x2 < 0.25f) {
+        return 1.0f - x2 * (1.0f / 6.0f) + x2 * x2 * (1.0f / 120.0f);
+    }
+    return fast_sinf(x) / x;
+}
+
+#endif // FAST_MATH_H
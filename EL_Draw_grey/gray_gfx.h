@@ -7,6 +7,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include "el.h"
+#include "simple_gfx.h"
 
 // Set a single pixel with 2-bit grayscale value (0-3)
 static inline void set_gray_pixel(unsigned char *gray_buf, int x, int y, uint8_t gray_value) {
@@ -79,6 +80,374 @@ static inline void draw_line_gray(unsigned char *gray_buf, int x0, int y0, int x
     }
 }
 
+// ========== 按字写入 ==========
+// A 32-bit word holds 16 pixels. Within a byte the first pixel is in bits
+// 7..6; words are little endian, so pixel x sits at bit
+// 8 * ((x >> 2) & 3) + 6 - 2 * (x & 3) of word x >> 4 of its row.
+#define GRAY_STRIDE_WORDS (SCR_WIDTH / 16)
+
+static inline int gray_word_shift(int x) {
+    return 8 * ((x >> 2) & 3) + 6 - 2 * (x & 3);
+}
+
+// Raise the pixels selected by mask (0b11 per pixel) to at least level, so
+// that where lines cross the brighter one wins in any drawing order
+static inline uint32_t gray_word_max(uint32_t w, uint32_t mask, uint8_t level) {
+    const uint32_t lo = mask & 0x55555555u;
+    switch (level) {
+        case 1:     // 0 -> 1
+            return w | (lo & ~(w | (w >> 1)));
+        case 2:     // 0, 1 -> 2, 3 stays
+            return (w & ~mask) | (lo << 1) | (w & (w >> 1) & lo);
+        case 3:
+            return w | mask;
+    }
+    return w;
+}
+
+// ========== 直线裁剪 ==========
+// Cohen-Sutherland outcode of a screen point, 0 when it is on screen
+#define GRAY_OUT_LEFT   1
+#define GRAY_OUT_RIGHT  2
+#define GRAY_OUT_TOP    4
+#define GRAY_OUT_BOTTOM 8
+
+static inline uint8_t gray_outcode(int x, int y) {
+    uint8_t code = 0;
+    if (x < 0) code |= GRAY_OUT_LEFT;
+    else if (x >= SCR_WIDTH) code |= GRAY_OUT_RIGHT;
+    if (y < 0) code |= GRAY_OUT_TOP;
+    else if (y >= SCR_HEIGHT) code |= GRAY_OUT_BOTTOM;
+    return code;
+}
+
+// round(a * b / c) with a 64-bit product, for clip intersections
+static inline int gray_muldiv_round(int a, int b, int c) {
+    int64_t n = (int64_t)a * b;
+    if ((n < 0) != (c < 0)) return (int)((n - c / 2) / c);
+    return (int)((n + c / 2) / c);
+}
+
+// Trim the line to the screen given the outcodes of its endpoints, so it
+// can go to draw_line_gray_fast. Returns false when nothing of it is visible.
+static inline bool gray_clip_line_oc(int *x0, int *y0, uint8_t c0, int *x1, int *y1, uint8_t c1) {
+    // Every pass moves one endpoint onto a screen edge; the cap only guards
+    // against rounding ping-pong
+    for (int pass = 0; c0 | c1; pass++) {
+        if ((c0 & c1) || pass == 8) return false;
+
+        uint8_t out = c0 ? c0 : c1;
+        int dx = *x1 - *x0, dy = *y1 - *y0;
+        int x, y;
+        if (out & GRAY_OUT_TOP) {
+            y = 0;
+            x = *x0 + gray_muldiv_round(dx, y - *y0, dy);
+        } else if (out & GRAY_OUT_BOTTOM) {
+            y = SCR_HEIGHT - 1;
+            x = *x0 + gray_muldiv_round(dx, y - *y0, dy);
+        } else if (out & GRAY_OUT_RIGHT) {
+            x = SCR_WIDTH - 1;
+            y = *y0 + gray_muldiv_round(dy, x - *x0, dx);
+        } else {
+            x = 0;
+            y = *y0 + gray_muldiv_round(dy, x - *x0, dx);
+        }
+
+        if (out == c0) {
+            *x0 = x;
+            *y0 = y;
+            c0 = gray_outcode(x, y);
+        } else {
+            *x1 = x;
+            *y1 = y;
+            c1 = gray_outcode(x, y);
+        }
+    }
+    return true;
+}
+
+// Line with both ends on screen, written into the packed buffer a word at a
+// time: along an x-major line the pixels of one row and word are collected
+// into a mask and merged with one read-modify-write. No divide or modulo
+// per pixel. Levels combine with gray_word_max().
+static inline void draw_line_gray_fast(unsigned char *gray_buf, int x0, int y0, int x1, int y1, uint8_t level) {
+    uint32_t *words = (uint32_t *)gray_buf;
+    int dx = abs(x1 - x0);
+    int dy = abs(y1 - y0);
+
+    if (dx >= dy) {
+        // Left to right, so the line is the same either way round
+        if (x0 > x1) {
+            int t = x0; x0 = x1; x1 = t;
+            t = y0; y0 = y1; y1 = t;
+        }
+        const int step = y0 < y1 ? GRAY_STRIDE_WORDS : -GRAY_STRIDE_WORDS;
+        uint32_t *row = words + y0 * GRAY_STRIDE_WORDS;
+        int err = dx / 2;
+        int wi = x0 >> 4;
+        uint32_t mask = 0;
+        for (int x = x0; x <= x1; x++) {
+            if ((x >> 4) != wi) {
+                row[wi] = gray_word_max(row[wi], mask, level);
+                mask = 0;
+                wi = x >> 4;
+            }
+            mask |= 3u << gray_word_shift(x);
+            err -= dy;
+            if (err < 0) {
+                err += dx;
+                row[wi] = gray_word_max(row[wi], mask, level);
+                mask = 0;
+                row += step;
+            }
+        }
+        if (mask) row[wi] = gray_word_max(row[wi], mask, level);
+    } else {
+        // Top to bottom, one pixel per row
+        if (y0 > y1) {
+            int t = x0; x0 = x1; x1 = t;
+            t = y0; y0 = y1; y1 = t;
+        }
+        const int sx = x0 < x1 ? 1 : -1;
+        uint32_t *row = words + y0 * GRAY_STRIDE_WORDS;
+        int err = dy / 2;
+        int x = x0;
+        for (int y = y0; y <= y1; y++) {
+            row[x >> 4] = gray_word_max(row[x >> 4], 3u << gray_word_shift(x), level);
+            row += GRAY_STRIDE_WORDS;
+            err -= dx;
+            if (err < 0) {
+                err += dy;
+                x += sx;
+            }
+        }
+    }
+}
+
+// ========== 抗锯齿线 ==========
+// Raise the pixel at bits shift+1..shift of a 2bpp byte to at least level,
+// by adding what is missing, without a branch
+static inline int gray_byte_max(int v, int shift, int level) {
+    const int d = level - ((v >> shift) & 3);
+    return v + ((d > 0 ? d : 0) << shift);
+}
+
+// Two neighbouring pixels of one byte taken as a nibble:
+// gray_aa_pair[level - 1][b][n] is nibble n with its left pixel raised to
+// at least level - b and its right one to at least b (b <= level)
+static const uint8_t gray_aa_pair[3][4][16] = {
+    {   // level 1
+        { 0x4, 0x5, 0x6, 0x7, 0x4, 0x5, 0x6, 0x7, 0x8, 0x9, 0xa, 0xb, 0xc, 0xd, 0xe, 0xf },
+        { 0x1, 0x1, 0x2, 0x3, 0x5, 0x5, 0x6, 0x7, 0x9, 0x9, 0xa, 0xb, 0xd, 0xd, 0xe, 0xf },
+        { 0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0x8, 0x9, 0xa, 0xb, 0xc, 0xd, 0xe, 0xf },
+        { 0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0x8, 0x9, 0xa, 0xb, 0xc, 0xd, 0xe, 0xf },
+    },
+    {   // level 2
+        { 0x8, 0x9, 0xa, 0xb, 0x8, 0x9, 0xa, 0xb, 0x8, 0x9, 0xa, 0xb, 0xc, 0xd, 0xe, 0xf },
+        { 0x5, 0x5, 0x6, 0x7, 0x5, 0x5, 0x6, 0x7, 0x9, 0x9, 0xa, 0xb, 0xd, 0xd, 0xe, 0xf },
+        { 0x2, 0x2, 0x2, 0x3, 0x6, 0x6, 0x6, 0x7, 0xa, 0xa, 0xa, 0xb, 0xe, 0xe, 0xe, 0xf },
+        { 0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0x8, 0x9, 0xa, 0xb, 0xc, 0xd, 0xe, 0xf },
+    },
+    {   // level 3
+        { 0xc, 0xd, 0xe, 0xf, 0xc, 0xd, 0xe, 0xf, 0xc, 0xd, 0xe, 0xf, 0xc, 0xd, 0xe, 0xf },
+        { 0x9, 0x9, 0xa, 0xb, 0x9, 0x9, 0xa, 0xb, 0x9, 0x9, 0xa, 0xb, 0xd, 0xd, 0xe, 0xf },
+        { 0x6, 0x6, 0x6, 0x7, 0x6, 0x6, 0x6, 0x7, 0xa, 0xa, 0xa, 0xb, 0xe, 0xe, 0xe, 0xf },
+        { 0x3, 0x3, 0x3, 0x3, 0x7, 0x7, 0x7, 0x7, 0xb, 0xb, 0xb, 0xb, 0xf, 0xf, 0xf, 0xf },
+    },
+};
+
+// One step of an x-major anti-aliased line: y is the exact row in 16.16,
+// col the column's byte in row 0. The pixel below gets the fraction; when
+// it gets nothing it is not touched, so no byte past the last row is read.
+static inline void gray_aa_step_x(unsigned char *col, int32_t y, int shift, int level, bool clip) {
+    const int stride = SCR_WIDTH / 4;
+    const int yi = y >> 16;
+    const int b = ((y & 0xffff) * level + 0x8000) >> 16;
+    unsigned char *p = col + yi * stride;
+    if (!clip || (unsigned)yi < SCR_HEIGHT) *p = gray_byte_max(*p, shift, level - b);
+    if (b && (!clip || (unsigned)(yi + 1) < SCR_HEIGHT)) p[stride] = gray_byte_max(p[stride], shift, b);
+}
+
+// x0..x1 of an x-major line. Whole bytes are done four steps at a time so
+// that every shift is a constant.
+static inline void gray_aa_run_x(unsigned char *gray_buf, int x0, int x1, int32_t y, int32_t grad,
+                                 int level, bool clip) {
+    int x = x0;
+    for (; x <= x1 && (x & 3); x++, y += grad)
+        gray_aa_step_x(gray_buf + (x >> 2), y, 6 - 2 * (x & 3), level, clip);
+    for (; x + 3 <= x1; x += 4) {
+        unsigned char *col = gray_buf + (x >> 2);
+        gray_aa_step_x(col, y, 6, level, clip);
+        gray_aa_step_x(col, y += grad, 4, level, clip);
+        gray_aa_step_x(col, y += grad, 2, level, clip);
+        gray_aa_step_x(col, y += grad, 0, level, clip);
+        y += grad;
+    }
+    for (; x <= x1; x++, y += grad)
+        gray_aa_step_x(gray_buf + (x >> 2), y, 6 - 2 * (x & 3), level, clip);
+}
+
+// One row of a y-major line with either pixel possibly off screen
+static inline void gray_aa_row_clip(unsigned char *row, int32_t x, int level) {
+    const int xi = x >> 16;
+    const int b = ((x & 0xffff) * level + 0x8000) >> 16;
+    if ((unsigned)xi < SCR_WIDTH)
+        row[xi >> 2] = gray_byte_max(row[xi >> 2], 6 - 2 * (xi & 3), level - b);
+    if (b && (unsigned)(xi + 1) < SCR_WIDTH)
+        row[(xi + 1) >> 2] = gray_byte_max(row[(xi + 1) >> 2], 6 - 2 * ((xi + 1) & 3), b);
+}
+
+// y0..y1 of a y-major line, x is the exact column in 16.16, with both
+// pixels of every row on screen (0 <= x < (SCR_WIDTH - 1) << 16). The pair
+// is a nibble of the big-endian 16-bit window over its byte and the next,
+// so a pair split over two bytes takes no branch of its own. The window
+// rewrites the byte after the pair's unchanged; in the last row that could
+// be past the buffer, so that row is done on its own.
+static inline void gray_aa_run_y(unsigned char *gray_buf, int y0, int y1, int32_t x, int32_t grad,
+                                 int level) {
+    const int stride = SCR_WIDTH / 4;
+    const uint8_t (*pair)[16] = gray_aa_pair[level - 1];
+    const int y_last = y1 < SCR_HEIGHT - 1 ? y1 : SCR_HEIGHT - 2;
+    unsigned char *row = gray_buf + y0 * stride;
+    int y = y0;
+    for (; y <= y_last; y++, x += grad, row += stride) {
+        const int xi = x >> 16;
+        const int b = ((x & 0xffff) * level + 0x8000) >> 16;
+        const int shift = 12 - 2 * (xi & 3);
+        unsigned char *p = row + (xi >> 2);
+        const int w = p[0] << 8 | p[1];
+        const int n = (w >> shift) & 15;
+        const int v = w + ((pair[b][n] - n) << shift);
+        p[0] = v >> 8;
+        p[1] = v;
+    }
+    if (y <= y1) gray_aa_row_clip(row, x, level);
+}
+
+// y0..y1 of a y-major line that leaves the screen sideways. x is monotonic,
+// so the rows with both pixels on screen are one run, steps k0..k1, found
+// with one divide; only the rows before and after it are checked per pixel.
+static inline void gray_aa_clip_y(unsigned char *gray_buf, int y0, int y1, int32_t x, int32_t grad,
+                                  int level) {
+    const int stride = SCR_WIDTH / 4;
+    const int32_t hi = (SCR_WIDTH - 1) << 16;
+    const int n = y1 - y0;
+    int k0, k1;
+    if (grad > 0) {
+        k0 = x >= 0 ? 0 : (-x + grad - 1) / grad;
+        k1 = x >= hi ? -1 : (hi - 1 - x) / grad;
+    } else if (grad < 0) {
+        k0 = x < hi ? 0 : (x - hi) / -grad + 1;
+        k1 = x < 0 ? -1 : x / -grad;
+    } else {
+        k0 = 0;
+        k1 = x >= 0 && x < hi ? n : -1;
+    }
+    if (k1 > n) k1 = n;
+
+    unsigned char *row = gray_buf + y0 * stride;
+    int k = 0;
+    for (; k <= n && k < k0; k++, x += grad, row += stride) gray_aa_row_clip(row, x, level);
+    if (k <= k1) {
+        gray_aa_run_y(gray_buf, y0 + k, y0 + k1, x, grad, level);
+        x += (k1 + 1 - k) * grad;
+        row += (k1 + 1 - k) * stride;
+        k = k1 + 1;
+    }
+    for (; k <= n; k++, x += grad, row += stride) gray_aa_row_clip(row, x, level);
+}
+
+// (d << 16) / n for 0 < n, |d| <= n: in 32 bits unless n is too long for
+// that, so only off-screen ends beyond +-32k take the 64-bit divide
+static inline int32_t gray_aa_grad(int d, int n) {
+    if (n < 32768) return d * 65536 / n;
+    return (int32_t)((int64_t)d * 65536 / n);
+}
+
+// Wu-style anti-aliased line. The position across the line is kept in
+// 16.16 fixed point and at each step the level is split between the two
+// pixels it falls between, in proportion to the fraction: a level 3 line
+// leaves 3+0, 2+1, 1+2 or 0+3, so its edges are drawn with levels 1 and 2,
+// and a lower level dims the whole line the same way. One divide per line,
+// none per pixel, and the 2bpp bytes are addressed directly; pixels keep
+// the brighter level, as with gray_word_max(). Clipped to the screen, with
+// per-pixel checks only when an end is off it. The part of the line over the
+// screen is found in 64 bits first, so ends far off screen neither overflow
+// the 16.16 position nor walk the rows or columns beside the screen.
+static inline void draw_line_gray_aa(unsigned char *gray_buf, int x0, int y0, int x1, int y1, uint8_t level) {
+    if (level == 0) return;
+    if (level > 3) level = 3;
+    int dx = abs(x1 - x0);
+    int dy = abs(y1 - y0);
+
+    if (dx >= dy) {
+        if (x0 > x1) {
+            int t = x0; x0 = x1; x1 = t;
+            t = y0; y0 = y1; y1 = t;
+        }
+        const int32_t grad = dx ? gray_aa_grad(y1 - y0, dx) : 0;
+        int64_t y = (int64_t)y0 * 65536;
+        if (x0 < 0) {
+            y -= (int64_t)grad * x0;
+            x0 = 0;
+        }
+        if (x1 >= SCR_WIDTH) x1 = SCR_WIDTH - 1;
+        if (x0 > x1) return;
+        // Exact rows at the clipped ends; rows -1 and SCR_HEIGHT - 1 still
+        // reach the screen with their second pixel
+        const int64_t y_end = y + (int64_t)grad * (x1 - x0);
+        const int64_t top = -65536, bottom = (int64_t)SCR_HEIGHT << 16;
+        if ((y <= top && y_end <= top) || (y >= bottom && y_end >= bottom)) return;
+        // The exact row never passes an end, so with both ends on screen
+        // (the second pixel included) the whole run is
+        const int64_t last = (int64_t)(SCR_HEIGHT - 1) << 16;
+        if (y >= 0 && y <= last && y_end >= 0 && y_end <= last)
+            gray_aa_run_x(gray_buf, x0, x1, (int32_t)y, grad, level, false);
+        else
+            gray_aa_run_x(gray_buf, x0, x1, (int32_t)y, grad, level, true);
+    } else {
+        if (y0 > y1) {
+            int t = x0; x0 = x1; x1 = t;
+            t = y0; y0 = y1; y1 = t;
+        }
+        const int32_t grad = gray_aa_grad(x1 - x0, dy);
+        int64_t x = (int64_t)x0 * 65536;
+        if (y0 < 0) {
+            x -= (int64_t)grad * y0;
+            y0 = 0;
+        }
+        if (y1 >= SCR_HEIGHT) y1 = SCR_HEIGHT - 1;
+        if (y0 > y1) return;
+        const int64_t x_end = x + (int64_t)grad * (y1 - y0);
+        const int64_t left = -65536, right = (int64_t)SCR_WIDTH << 16;
+        if ((x <= left && x_end <= left) || (x >= right && x_end >= right)) return;
+        // Both ends' pairs on screen: so is every row's
+        const int64_t hi = (int64_t)(SCR_WIDTH - 1) << 16;
+        if (x >= 0 && x < hi && x_end >= 0 && x_end < hi)
+            gray_aa_run_y(gray_buf, y0, y1, (int32_t)x, grad, level);
+        else
+            gray_aa_clip_y(gray_buf, y0, y1, (int32_t)x, grad, level);
+    }
+}
+
+// Text in the 5x7 font of simple_gfx.h
+static inline void draw_string_gray(unsigned char *gray_buf, int x, int y, const char *str, int size, uint8_t gray_value) {
+    for (; *str; str++, x += 6 * size) {
+        if (*str < ' ' || *str > 'z') continue;
+        const uint8_t *char_data = font5x7[*str - ' '];
+        for (int col = 0; col < 5; col++) {
+            for (int row = 0; row < 7; row++) {
+                if (!(char_data[col] & (1 << row))) continue;
+                for (int sy = 0; sy < size; sy++) {
+                    for (int sx = 0; sx < size; sx++) {
+                        set_gray_pixel(gray_buf, x + col * size + sx, y + row * size + sy, gray_value);
+                    }
+                }
+            }
+        }
+    }
+}
+
 // Draw a circle with grayscale value (Midpoint algorithm)
 static inline void draw_circle_gray(unsigned char *gray_buf, int cx, int cy, int radius, uint8_t gray_value) {
     int x = radius;
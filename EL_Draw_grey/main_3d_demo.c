@@ -67,9 +67,11 @@ void core1_entry() {
         }
         frame_count++;
 
+        // 灰度帧画完后转换成 4 个二值帧，由 core0 在 4 帧周期结束时交换；
+        // 等 core0 确认后再画下一帧，帧率跟随 30 Hz 的灰度周期
+        el_update_frame();
         multicore_fifo_push_blocking(1);
-
-        sleep_ms(30);
+        multicore_fifo_pop_blocking();
     }
 }
 
@@ -109,21 +111,21 @@ int main()
 
     uint32_t swap_count = 0;
     while(1) {
-        if (multicore_fifo_rvalid()) {
-            multicore_fifo_pop_blocking();
-            el_swap_buffer();
-            swap_count++;
-
-            if (swap_count % 500 == 0) {
-                printf("Swap count: %d, current model: %d\n", swap_count, current_model);
-                print_memory_info();
-                watchdog_update();
-                gpio_put(LED_PIN, 1);
-                sleep_ms(2);
-                gpio_put(LED_PIN, 0);
-            }
+        // Sleeps in the FIFO until core1 has a frame, so the swap starts as
+        // soon as it is ready instead of up to one poll period later
+        multicore_fifo_pop_blocking();
+        el_swap_buffer();
+        multicore_fifo_push_blocking(1);
+        swap_count++;
+
+        if (swap_count % 500 == 0) {
+            printf("Swap count: %d, current model: %d\n", swap_count, current_model);
+            print_memory_info();
+            watchdog_update();
+            gpio_put(LED_PIN, 1);
+            sleep_ms(2);
+            gpio_put(LED_PIN, 0);
         }
-        sleep_us(100);
     }
 
     deinit_mesh();
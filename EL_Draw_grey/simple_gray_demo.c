@@ -10,6 +10,7 @@
 #include "hardware/watchdog.h"
 #include "el.h"
 #include "gray_gfx.h"
+#include "fast_math.h"
 
 const uint LED_PIN = PICO_DEFAULT_LED_PIN;
 
@@ -27,8 +28,8 @@ void draw_animated_circles(unsigned char *gray_buf, AnimState *state) {
     // Draw multiple circles with different gray levels
     for (int i = 0; i < 4; i++) {
         float offset_angle = state->angle + (i * M_PI / 2.0f);
-        int x = state->center_x + (int)(100.0f * cosf(offset_angle));
-        int y = state->center_y + (int)(80.0f * sinf(offset_angle));
+        int x = state->center_x + (int)(100.0f * fast_cosf(offset_angle));
+        int y = state->center_y + (int)(80.0f * fast_sinf(offset_angle));
         
         fill_circle_gray(gray_buf, x, y, 40, i); // Different gray level for each
     }
@@ -37,16 +38,30 @@ void draw_animated_circles(unsigned char *gray_buf, AnimState *state) {
 }
 
 // Draw animated wave pattern
+// The wave is separable, sin(x term) * sin(y term): one table of column terms
+// per frame and one lookup per row, written straight into the packed 2bpp
+// buffer four pixels per byte. Every byte is overwritten, so no clear is needed.
 void draw_wave_pattern(unsigned char *gray_buf, AnimState *state) {
-    clear_gray_screen(gray_buf, 0);
+    static float col_wave[SCR_WIDTH];
+    float phase = state->angle * 10.0f;
+    
+    for (int x = 0; x < SCR_WIDTH; x++) {
+        col_wave[x] = fast_sinf((x + phase) * 0.02f);
+    }
     
     for (int y = 0; y < SCR_HEIGHT; y++) {
-        for (int x = 0; x < SCR_WIDTH; x++) {
-            float wave = sinf((x + state->angle * 10.0f) * 0.02f) * 
-                        sinf((y + state->angle * 10.0f) * 0.02f);
-            uint8_t gray = (uint8_t)((wave + 1.0f) * 1.5f); // Map to 0-3
-            if (gray > 3) gray = 3;
-            set_gray_pixel(gray_buf, x, y, gray);
+        float row_wave = fast_sinf((y + phase) * 0.02f);
+        unsigned char *row = gray_buf + y * (SCR_WIDTH / 4);
+        
+        for (int x = 0; x < SCR_WIDTH; x += 4) {
+            uint8_t packed = 0;
+            for (int k = 0; k < 4; k++) {
+                float wave = col_wave[x + k] * row_wave;
+                uint8_t gray = (uint8_t)((wave + 1.0f) * 1.5f); // Map to 0-3
+                if (gray > 3) gray = 3;
+                packed |= gray << (6 - 2 * k);
+            }
+            row[x / 4] = packed;
         }
     }
     
@@ -86,8 +101,8 @@ void draw_rotating_squares(unsigned char *gray_buf, AnimState *state) {
     float angle = state->angle;
     for (int i = 0; i < 3; i++) {
         float a = angle + i * (M_PI * 2.0f / 3.0f);
-        int x = state->center_x + (int)(150.0f * cosf(a));
-        int y = state->center_y + (int)(120.0f * sinf(a));
+        int x = state->center_x + (int)(150.0f * fast_cosf(a));
+        int y = state->center_y + (int)(120.0f * fast_sinf(a));
         fill_rect_gray(gray_buf, x - 20, y - 20, 40, 40, i + 1);
     }
     
@@ -98,7 +113,7 @@ void draw_rotating_squares(unsigned char *gray_buf, AnimState *state) {
 void draw_pulse_pattern(unsigned char *gray_buf, AnimState *state) {
     clear_gray_screen(gray_buf, 0);
     
-    float pulse = (sinf(state->angle) + 1.0f) / 2.0f; // 0 to 1
+    float pulse = (fast_sinf(state->angle) + 1.0f) / 2.0f; // 0 to 1
     
     for (int ring = 0; ring < 5; ring++) {
         int radius = (int)(30.0f + ring * 40.0f + pulse * 30.0f);